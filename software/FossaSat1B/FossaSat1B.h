@@ -1,6 +1,10 @@
 // C++ libraries
 #include <string.h>
 
+// AVR libraries
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
 // Arduino libraries
 #include <Wire.h>
 
@@ -16,11 +20,18 @@
 #include <RadioLib.h>
 
 // files
+#include "command_queue.h"
 #include "communication.h"
 #include "configuration.h"
 #include "debugging_utilities.h"
 #include "deployment.h"
 #include "persistent_storage.h"
 #include "pin_interface.h"
+#include "post_mortem.h"
 #include "power_control.h"
+#include "recording.h"
+#include "scheduler.h"
+#include "spin_estimation.h"
+#include "statistics.h"
 #include "system_info.h"
+#include "timekeeping.h"
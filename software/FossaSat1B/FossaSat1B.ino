@@ -16,6 +16,10 @@
   #error "RadioLib is using dynamic memory management, make sure static only is enabled in RadioLib/src/BuildOpt.h"
 #endif
 
+#if (RESP_PUBLIC_FIRST <= RESP_ACKNOWLEDGE) || (RESP_PUBLIC_FIRST <= RESP_RECORDED_SOLAR_CELLS)
+  #error "Extended response IDs overlap FOSSA-Comms response IDs!"
+#endif
+
 #ifndef UNIT_TEST
 // cppcheck-suppress unusedFunction
 void setup() {
@@ -23,25 +27,50 @@ void setup() {
   FOSSASAT_DEBUG_PORT.begin(FOSSASAT_DEBUG_SPEED);
   FOSSASAT_DEBUG_PORT.println();
 
-  // increment reset counter
+  // load configuration into RAM
+  Persistent_Storage_Load_Config();
+  System_Info_Load_Callsign();
+
+  // increment reset counter, save it right away to count restarts during setup
   FOSSASAT_DEBUG_PORT.print('R');
   FOSSASAT_DEBUG_PORT.println(Persistent_Storage_Read<uint16_t>(EEPROM_RESTART_COUNTER_ADDR));
   Persistent_Storage_Increment_Counter(EEPROM_RESTART_COUNTER_ADDR);
+  Persistent_Storage_Flush();
 
-  // setup pins
+  // setup pins and start signalling the watchdog
   Configuration_Setup_Pins();
+  Pin_Interface_Watchdog_Start();
+
+  // recover the latest values of frequently updated counters, and continue counting time from the last saved value
+  bool logFound = Persistent_Storage_Load_Log();
+  Timekeeping_Init(logRecord.uptimeCounter);
+  Timekeeping_Calibrate();
+
+  // save cause of the last reset
+  Post_Mortem_Init();
+
+  // expand encryption key for private frames
+  Communication_Init_Encryption();
 
   // check if this is the first run
   if(Persistent_Storage_Read<uint8_t>(EEPROM_FIRST_RUN_ADDR) != EEPROM_CONSECUTIVE_RUN) {
-    // first run, set EEPROM flag
+    // first run, set EEPROM flag and layout version
     Persistent_Storage_Write<uint8_t>(EEPROM_FIRST_RUN_ADDR, EEPROM_CONSECUTIVE_RUN);
+    Persistent_Storage_Write<uint8_t>(EEPROM_LAYOUT_VERSION_ADDR, EEPROM_LAYOUT_VERSION);
 
   } else {
-    // consecutive run, load power control configuration
+    // consecutive run, convert EEPROM written by older firmware and load power control configuration
+    Persistent_Storage_Migrate(logFound);
     Power_Control_Load_Configuration();
 
   }
 
+  // load statistics accumulators
+  Statistics_Load();
+
+  // load battery charge estimate
+  Power_Control_Load_Charge();
+
   // print power configuration
   FOSSASAT_DEBUG_PORT.print('C');
   FOSSASAT_DEBUG_PORT.println(powerConfig.val, BIN);
@@ -126,17 +155,13 @@ void setup() {
 
           FOSSASAT_DEBUG_PORT.println();
         }
-
-        // pet watchdog
-        if (millis() - lastHeartbeat >= WATCHDOG_LOOP_HEARTBEAT_PERIOD) {
-          lastHeartbeat = millis();
-          Pin_Interface_Watchdog_Heartbeat();
-        }
       }
 
       // increment deployment counter
       FOSSASAT_DEBUG_PORT.println(F("INTDONE"));
       Persistent_Storage_Write<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR, attemptNumber + 1);
+      Persistent_Storage_Flush();
+      Pin_Interface_Watchdog_Extend(DEPLOYMENT_SLEEP_LENGTH);
       Power_Control_Delay(DEPLOYMENT_SLEEP_LENGTH, true, true);
 
     } else if(Persistent_Storage_Read<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR) <= DEPLOYMENT_ATTEMPTS) {
@@ -144,6 +169,7 @@ void setup() {
       FOSSASAT_DEBUG_PRINT('S');
       FOSSASAT_DEBUG_PRINTLN(DEPLOYMENT_SLEEP_LENGTH);
       FOSSASAT_DEBUG_DELAY(10);
+      Pin_Interface_Watchdog_Extend(DEPLOYMENT_SLEEP_LENGTH);
       Power_Control_Delay(DEPLOYMENT_SLEEP_LENGTH, true, true);
 
       // deploy
@@ -152,170 +178,18 @@ void setup() {
 
   #endif
 
-  // reset uptime counter
-  Persistent_Storage_Write<uint32_t>(EEPROM_UPTIME_COUNTER_ADDR, 0);
+  // save current time
+  Persistent_Storage_Save_Log();
+  Persistent_Storage_Flush();
+
+  // start scheduling tasks
+  Scheduler_Init();
 }
 
 // cppcheck-suppress unusedFunction
 void loop() {
-  // variable to measure time when not in sleep mode
-  uint32_t activeStart = millis();
-
-  // get loop number
-  uint8_t numLoops = Persistent_Storage_Read<uint8_t>(EEPROM_LOOP_COUNTER);
-
-  // check battery voltage
-  FOSSASAT_DEBUG_PRINT('B');
-  #ifdef ENABLE_INA226
-  float battVoltage = Power_Control_Get_Battery_Voltage();
-  #else
-  float battVoltage = 3.99;
-  #endif
-  FOSSASAT_DEBUG_PRINTLN(battVoltage, 2);
-  Power_Control_Check_Battery_Limit();
-  FOSSASAT_DEBUG_PRINT('C');
-  FOSSASAT_DEBUG_PRINTLN(powerConfig.val, BIN);
-
-  // try to switch MPPT on (may be overridden by temperature check)
-  Power_Control_Charge(true);
-
-  // CW beacon
-  bool beaconSent = false;
-  Communication_Set_Modem(MODEM_FSK);
-  FOSSASAT_DEBUG_DELAY(10);
-  #ifdef ENABLE_TRANSMISSION_CONTROL
-  if(!powerConfig.bits.transmitEnabled) {
-    FOSSASAT_DEBUG_PRINTLN(F("Tx off"));
-  } else {
-  #endif
-
-  if((battVoltage >= BATTERY_CW_BEEP_VOLTAGE_LIMIT) && (numLoops % MORSE_BEACON_LOOP_FREQ == 0)) {
-    // transmit full Morse beacon
-    Communication_Send_Morse_Beacon(battVoltage);
-    beaconSent = true;
-  } else {
-    // set delay between beeps according to battery voltage
-    float delayLen = battVoltage - MORSE_BATTERY_MIN;
-    if(battVoltage < MORSE_BATTERY_MIN + MORSE_BATTERY_STEP) {
-      delayLen = MORSE_BATTERY_STEP;
-    }
-
-    // this isn't the loop to transmit full Morse beacon, or the battery is low, transmit CW beeps
-    for(uint8_t i = 0; i < NUM_CW_BEEPS; i++) {
-      Communication_CW_Beep(500 * SLEEP_LENGTH_CONSTANT);
-      Power_Control_Delay(delayLen * 1000 * SLEEP_LENGTH_CONSTANT, true);
-    }
-  }
-
-  #ifdef ENABLE_TRANSMISSION_CONTROL
-  }
-  #endif
-
-  // wait for a bit
-  FOSSASAT_DEBUG_DELAY(10);
-  Power_Control_Delay(500, true, true);
-
-  // send FSK system info
-  Communication_Set_Modem(MODEM_FSK);
-  Communication_Send_System_Info();
-
-  // wait for a bit
-  FOSSASAT_DEBUG_DELAY(10);
-  Power_Control_Delay(500, true, true);
-
-  // send LoRa system info if not in low power mode
-  Communication_Set_Modem(MODEM_LORA);
-  #ifdef ENABLE_INTERVAL_CONTROL
-  if(!powerConfig.bits.lowPowerModeActive) {
-    Communication_Send_System_Info();
-  }
-  #else
-    Communication_Send_System_Info();
-  #endif
-
-  // wait for a bit
-  FOSSASAT_DEBUG_DELAY(10);
-  Power_Control_Delay(500, true, true);
-
-  // LoRa receive
-  uint8_t windowLenLoRa = Persistent_Storage_Read<uint8_t>(EEPROM_LORA_RECEIVE_LEN_ADDR);
-  FOSSASAT_DEBUG_PRINT(F("LR"));
-  if(powerConfig.bits.lowPowerModeActive) {
-    // use only half of the interval in low power mode
-    windowLenLoRa /= 2;
-  }
-  FOSSASAT_DEBUG_PRINTLN(windowLenLoRa);
-  radio.setDio1Action(Communication_Receive_Interrupt);
-  radio.startReceive();
-
-  for(uint8_t i = 0; i < windowLenLoRa * SLEEP_LENGTH_CONSTANT; i++) {
-    Power_Control_Delay(1000, true);
-    if(dataReceived) {
-      radio.standby();
-      Communication_Process_Packet();
-      radio.startReceive();
-    }
-  }
-
-  // GFSK receive
-  uint8_t windowLenFsk = Persistent_Storage_Read<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR);
-  Communication_Set_Modem(MODEM_FSK);
-  FOSSASAT_DEBUG_PRINT(F("FR"));
-  if(powerConfig.bits.lowPowerModeActive) {
-    // use only half of the interval in low power mode
-    windowLenFsk /= 2;
-  }
-  FOSSASAT_DEBUG_PRINTLN(windowLenFsk);
-  radio.setDio1Action(Communication_Receive_Interrupt);
-  radio.startReceive();
-
-  for(uint8_t i = 0; i < windowLenFsk * SLEEP_LENGTH_CONSTANT; i++) {
-    Power_Control_Delay(1000, true);
-    if(dataReceived) {
-      radio.standby();
-      Communication_Process_Packet();
-      radio.startReceive();
-    }
-  }
-
-  radio.clearDio1Action();
-
-  // set everything to sleep
-  uint32_t interval = Power_Control_Get_Sleep_Interval();
-  FOSSASAT_DEBUG_PRINT('S');
-  FOSSASAT_DEBUG_PRINTLN(interval);
-  FOSSASAT_DEBUG_DELAY(10);
-  Power_Control_Delay(interval * SLEEP_LENGTH_CONSTANT, true, true);
-
-  // update loop counter
-  numLoops++;
-  Persistent_Storage_Write<uint8_t>(EEPROM_LOOP_COUNTER, numLoops);
-
-  // check automated deployment attempts
-  uint32_t uptimeCounter = Persistent_Storage_Read<uint32_t>(EEPROM_UPTIME_COUNTER_ADDR);
-  uint8_t attempts = Persistent_Storage_Read<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR);
-  if((attempts <= DEPLOYMENT_ATTEMPTS) && (uptimeCounter >= AUTODEPLOY_DELAY)) {
-    // deployment attemp limit not reached yet, attempt more deployments
-    Deployment_Deploy();
-  }
-
-  // update uptime counter
-  uint32_t activeElapsed = (millis() - activeStart + 500)/1000;
-  FOSSASAT_DEBUG_PRINT('a');
-  FOSSASAT_DEBUG_PRINTLN(activeElapsed);
-
-  uint32_t elapsedTotal = 2 + windowLenLoRa + windowLenFsk + activeElapsed + interval;
-  if(beaconSent) {
-    // transmitting full Morse beacon takes about 9 seconds
-    elapsedTotal += 9;
-  } else {
-    elapsedTotal += NUM_CW_BEEPS;
-  }
-  FOSSASAT_DEBUG_PRINT('t');
-  FOSSASAT_DEBUG_PRINTLN(elapsedTotal);
-
-  uptimeCounter += elapsedTotal;
-  Persistent_Storage_Write<uint32_t>(EEPROM_UPTIME_COUNTER_ADDR,  uptimeCounter);
+  // run the next due task, or sleep until there is one
+  Scheduler_Run();
 }
 #endif // UNIT_TEST
 
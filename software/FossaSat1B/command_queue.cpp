@@ -0,0 +1,165 @@
+#include "command_queue.h"
+
+// slot of the command that is being executed, CMD_QUEUE_ALL when none
+uint8_t commandQueueActiveSlot = CMD_QUEUE_ALL;
+
+static uint16_t Command_Queue_Get_Addr(uint8_t slot) {
+  return(EEPROM_COMMAND_QUEUE_ADDR + slot*sizeof(commandQueueEntry_t));
+}
+
+static commandQueueEntry_t Command_Queue_Read(uint8_t slot) {
+  return(Persistent_Storage_Read<commandQueueEntry_t>(Command_Queue_Get_Addr(slot)));
+}
+
+static void Command_Queue_Write(uint8_t slot, const commandQueueEntry_t& entry) {
+  Persistent_Storage_Write<commandQueueEntry_t>(Command_Queue_Get_Addr(slot), entry);
+}
+
+uint8_t Command_Queue_Add(uint32_t delay, uint8_t functionId, uint8_t* optData, uint8_t optDataLen) {
+  // only known commands with responses that can be captured, queue commands can't be queued either
+  commandDef_t cmd;
+  if((optDataLen > CMD_QUEUE_DATA_LENGTH) || !Communication_Get_Command(functionId, &cmd) || (cmd.flags & CMD_FLAG_NO_QUEUE)) {
+    return(CMD_QUEUE_ALL);
+  }
+
+  // find a free slot, or the oldest executed one
+  uint8_t slot = CMD_QUEUE_ALL;
+  uint32_t oldest = UINT32_MAX;
+  for(uint8_t i = 0; i < CMD_QUEUE_NUM_SLOTS; i++) {
+    commandQueueEntry_t entry = Command_Queue_Read(i);
+    if((entry.state != CMD_QUEUE_PENDING) && (entry.state != CMD_QUEUE_DONE)) {
+      slot = i;
+      break;
+    }
+
+    if((entry.state == CMD_QUEUE_DONE) && (entry.time < oldest)) {
+      slot = i;
+      oldest = entry.time;
+    }
+  }
+
+  if(slot == CMD_QUEUE_ALL) {
+    return(CMD_QUEUE_ALL);
+  }
+
+  commandQueueEntry_t entry;
+  entry.time = Timekeeping_Get_Time() + delay;
+  entry.state = CMD_QUEUE_PENDING;
+  entry.id = functionId;
+  entry.len = optDataLen;
+  memset(entry.data, 0, CMD_QUEUE_DATA_LENGTH);
+  memcpy(entry.data, optData, optDataLen);
+  Command_Queue_Write(slot, entry);
+
+  // let the queue task find the new nearest target time
+  Scheduler_Arm(SCHED_TASK_COMMAND_QUEUE, 0);
+  return(slot);
+}
+
+void Command_Queue_Clear(uint8_t slot) {
+  for(uint8_t i = 0; i < CMD_QUEUE_NUM_SLOTS; i++) {
+    if((slot == CMD_QUEUE_ALL) || (slot == i)) {
+      Persistent_Storage_Write<uint8_t>(Command_Queue_Get_Addr(i) + offsetof(commandQueueEntry_t, state), CMD_QUEUE_EMPTY);
+    }
+  }
+}
+
+static void Command_Queue_Execute(uint8_t slot, commandQueueEntry_t& entry) {
+  uint8_t functionId = entry.id;
+  uint8_t optDataLen = entry.len;
+  uint8_t optData[CMD_QUEUE_DATA_LENGTH];
+  memcpy(optData, entry.data, CMD_QUEUE_DATA_LENGTH);
+  FOSSASAT_DEBUG_PRINT(F("Q"));
+  FOSSASAT_DEBUG_PRINTLN(functionId, HEX);
+
+  // mark as executed first, so that commands that restart the satellite are not repeated
+  entry.time = Timekeeping_Get_Time();
+  entry.state = CMD_QUEUE_DONE;
+  entry.id = 0;
+  entry.len = 0;
+  Command_Queue_Write(slot, entry);
+
+  // queued commands are not received in a frame, look them up by ID
+  commandDef_t cmd;
+  if(!Communication_Get_Command(functionId, &cmd)) {
+    return;
+  }
+
+  commandQueueActiveSlot = slot;
+  Communication_Execute_Function(cmd, optData, optDataLen);
+  commandQueueActiveSlot = CMD_QUEUE_ALL;
+}
+
+void Command_Queue_Run() {
+  uint32_t now = Timekeeping_Get_Time();
+  uint32_t next = UINT32_MAX;
+  for(uint8_t i = 0; i < CMD_QUEUE_NUM_SLOTS; i++) {
+    commandQueueEntry_t entry = Command_Queue_Read(i);
+    if(entry.state != CMD_QUEUE_PENDING) {
+      continue;
+    }
+
+    if(entry.time <= now) {
+      Command_Queue_Execute(i, entry);
+    } else if(entry.time < next) {
+      next = entry.time;
+    }
+  }
+
+  if(next != UINT32_MAX) {
+    Scheduler_Arm(SCHED_TASK_COMMAND_QUEUE, next - now);
+  }
+}
+
+bool Command_Queue_Capture_Response(uint8_t respId, uint8_t* optData, uint8_t optDataLen) {
+  if(commandQueueActiveSlot == CMD_QUEUE_ALL) {
+    return(false);
+  }
+
+  // later responses replace earlier ones (e.g. acknowledge), command may also have wiped the queue
+  commandQueueEntry_t entry = Command_Queue_Read(commandQueueActiveSlot);
+  if(entry.state == CMD_QUEUE_DONE) {
+    entry.id = respId;
+    entry.len = optDataLen;
+    memset(entry.data, 0, CMD_QUEUE_DATA_LENGTH);
+    memcpy(entry.data, optData, min(optDataLen, (uint8_t)CMD_QUEUE_DATA_LENGTH));
+    Command_Queue_Write(commandQueueActiveSlot, entry);
+  }
+  return(true);
+}
+
+uint8_t Command_Queue_Get_Status(uint8_t* buff) {
+  uint8_t* buffPtr = buff;
+  uint32_t now = Timekeeping_Get_Time();
+  for(uint8_t i = 0; i < CMD_QUEUE_NUM_SLOTS; i++) {
+    commandQueueEntry_t entry = Command_Queue_Read(i);
+    int32_t offset = (int32_t)(entry.time - now);
+    if((entry.state != CMD_QUEUE_PENDING) && (entry.state != CMD_QUEUE_DONE)) {
+      entry.state = CMD_QUEUE_EMPTY;
+      entry.id = 0;
+      offset = 0;
+    }
+
+    *buffPtr++ = entry.state;
+    *buffPtr++ = entry.id;
+    memcpy(buffPtr, &offset, sizeof(int32_t));
+    buffPtr += sizeof(int32_t);
+  }
+  return(buffPtr - buff);
+}
+
+bool Command_Queue_Get_Response(uint8_t slot, uint8_t* respId, uint8_t* buff, uint8_t* len) {
+  if(slot >= CMD_QUEUE_NUM_SLOTS) {
+    return(false);
+  }
+
+  commandQueueEntry_t entry = Command_Queue_Read(slot);
+  if((entry.state != CMD_QUEUE_DONE) || (entry.id == 0)) {
+    return(false);
+  }
+
+  *respId = entry.id;
+  *len = min(entry.len, (uint8_t)CMD_QUEUE_DATA_LENGTH);
+  memcpy(buff, entry.data, *len);
+  return(true);
+}
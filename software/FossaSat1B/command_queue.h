@@ -0,0 +1,72 @@
+#ifndef COMMAND_QUEUE_H_INCLUDED
+#define COMMAND_QUEUE_H_INCLUDED
+
+#include "FossaSat1B.h"
+
+/**
+ * @file command_queue.h
+ * @brief This module keeps time-tagged commands in EEPROM and executes them when they are due. Responses of executed
+ * commands are captured instead of transmitted and stored in the same slot, see @ref defines_command_queue.
+ */
+
+/**
+ * @brief Stores a command in a free slot. When there is none, the slot of the oldest executed command is reused.
+ *
+ * @test (ID CMD_QUEUE_H_T0) (SEV 1) Check that a command is rejected when all slots are pending.
+ * @test (ID CMD_QUEUE_H_T2) (SEV 1) Check that commands with CMD_FLAG_NO_QUEUE are rejected.
+ *
+ * @param delay Time from now until the command is due (s).
+ * @param functionId Function ID of the command.
+ * @param optData Optional data of the command.
+ * @param optDataLen Optional data length, at most CMD_QUEUE_DATA_LENGTH.
+ * @return uint8_t Slot index, or CMD_QUEUE_ALL when the command was rejected (no free slot, unknown function ID
+ * or CMD_FLAG_NO_QUEUE set).
+ */
+uint8_t Command_Queue_Add(uint32_t delay, uint8_t functionId, uint8_t* optData, uint8_t optDataLen);
+
+/**
+ * @brief Frees a slot, pending command will not be executed.
+ *
+ * @param slot Slot index, or CMD_QUEUE_ALL to free all slots.
+ */
+void Command_Queue_Clear(uint8_t slot);
+
+/**
+ * @brief Executes all due commands and arms SCHED_TASK_COMMAND_QUEUE for the nearest pending one.
+ *
+ * @test (ID CMD_QUEUE_H_T1) (SEV 1) Check that a command due during a restart is executed once after the restart.
+ *
+ */
+void Command_Queue_Run();
+
+/**
+ * @brief Stores response of the command that is being executed by Command_Queue_Run.
+ *
+ * @param respId Response function ID.
+ * @param optData Optional data of the response.
+ * @param optDataLen Optional data length, only the first CMD_QUEUE_DATA_LENGTH bytes are stored.
+ * @return bool Whether the response was stored, false when no queued command is being executed.
+ */
+bool Command_Queue_Capture_Response(uint8_t respId, uint8_t* optData, uint8_t optDataLen);
+
+/**
+ * @brief Gets state of all slots: state, function ID and signed time offset (int32_t, s) per slot.
+ * The offset is positive for pending commands (time until due) and negative for executed ones (time since execution).
+ *
+ * @param buff Buffer to write to, at least 6 * CMD_QUEUE_NUM_SLOTS bytes.
+ * @return uint8_t Number of bytes written.
+ */
+uint8_t Command_Queue_Get_Status(uint8_t* buff);
+
+/**
+ * @brief Gets stored response of an executed command.
+ *
+ * @param slot Slot index.
+ * @param respId Response function ID.
+ * @param buff Buffer to write the optional data to, at least CMD_QUEUE_DATA_LENGTH bytes.
+ * @param len Length of the stored optional data.
+ * @return bool Whether the slot holds a response.
+ */
+bool Command_Queue_Get_Response(uint8_t slot, uint8_t* respId, uint8_t* buff, uint8_t* len);
+
+#endif
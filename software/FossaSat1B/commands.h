@@ -0,0 +1,111 @@
+#ifndef COMMANDS_H_INCLUDED
+#define COMMANDS_H_INCLUDED
+
+/**
+ * @file commands.h
+ * @brief Function IDs and command table shared by the satellite and the ground station, see @ref defines_command_table.
+ * This file must not depend on anything but FOSSA-Comms, so that the ground station can include it.
+ */
+
+/**
+ * @defgroup defines_extended_function_ids Extended Function IDs
+ *
+ * @brief Function IDs not defined by FOSSA-Comms. Commands continue the private (encrypted) range after CMD_ROUTE,
+ * responses are allocated downwards from the end of public range, so they are never encrypted.
+ *
+ * @test (ID CONF_EXT_FUNC_ID_T0) (SEV 1) Check that extended responses are decoded by the ground station as public frames.
+ *
+ * @{
+ */
+#define CMD_GET_SPIN_RATE                               (CMD_ROUTE + 0x01)
+#define CMD_START_ADC_BURST                             (CMD_ROUTE + 0x02)
+#define CMD_GET_ADC_BURST                               (CMD_ROUTE + 0x03)
+#define CMD_GET_EPOCH_STATISTICS                        (CMD_ROUTE + 0x04)
+#define CMD_RESET_EPOCH_STATISTICS                      (CMD_ROUTE + 0x05)
+#define CMD_SET_TASK_SCHEDULE                           (CMD_ROUTE + 0x06)
+#define CMD_SET_LISTEN_MODEM                            (CMD_ROUTE + 0x07)
+#define CMD_QUEUE_COMMAND                               (CMD_ROUTE + 0x08)
+#define CMD_GET_COMMAND_QUEUE                           (CMD_ROUTE + 0x09)
+#define CMD_CLEAR_COMMAND_QUEUE                         (CMD_ROUTE + 0x0A)
+#define CMD_GET_SOLAR_RECORDING                         (CMD_ROUTE + 0x0B)
+#define CMD_GET_POST_MORTEM                             (CMD_ROUTE + 0x0C)
+#define CMD_SET_SYNC_WORD_PROFILE                       (CMD_ROUTE + 0x0D)
+#define CMD_SET_BATTERY_CAPACITY                        (CMD_ROUTE + 0x0E)
+
+#define RESP_SPIN_RATE                                  (PRIVATE_OFFSET - 0x01)
+#define RESP_EPOCH_STATISTICS                           (PRIVATE_OFFSET - 0x02)
+#define RESP_COMMAND_QUEUE                              (PRIVATE_OFFSET - 0x03)
+#define RESP_SOLAR_RECORDING_STATUS                     (PRIVATE_OFFSET - 0x04)
+#define RESP_POST_MORTEM                                (PRIVATE_OFFSET - 0x05)
+#define RESP_PUBLIC_FIRST                               RESP_POST_MORTEM
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_command_table Command Table
+ *
+ * @brief Every command is defined by one entry of COMMAND_TABLE, given as
+ * X(function ID, min length, max length, flags, energy cost, handler). Frames are validated against the table before
+ * the handler is called, so handlers don't check the length of the optional data again. Energy cost is compared
+ * with the battery charge above TX_RESERVE_SOC, commands that can't be covered are refused.
+ * Refused commands are valid frames, they are acknowledged with result CMD_REFUSED and counted separately from
+ * invalid frames.
+ * The ground station uses the same table to select encryption and check lengths, handlers are only expanded
+ * by the satellite.
+ *
+ * @test (ID CONF_CMD_T0) (SEV 1) Check that optional data shorter or longer than the table allows is answered by NACK_LENGTH.
+ * @test (ID CONF_CMD_T1) (SEV 1) Check that unencrypted frames with private function ID are rejected.
+ *
+ * @{
+ */
+#define MAX_STRING_LENGTH                               32          /*!< String length limit (bytes). */
+#define MAX_OPT_DATA_LENGTH                             128         /*!< Optional data length limit (bytes). */
+#define CMD_QUEUE_DATA_LENGTH                           22          /*!< Maximum length of stored optional data or response of queued command (bytes). */
+#define CMD_REFUSED                                     0x07        /*!< Acknowledge result of commands not allowed in low power mode, or that battery can't cover. */
+#define CMD_FLAG_ENCRYPTED                              0x01        /*!< Optional data is encrypted, function ID is private. */
+#define CMD_FLAG_LOW_POWER                              0x02        /*!< Command is allowed in low power mode. */
+#define CMD_FLAG_NO_QUEUE                               0x04        /*!< Command can't be queued, it transmits outside of Communication_Send_Response or manages the queue. */
+#define CMD_ENERGY_NONE                                 0           /*!< Command only changes configuration (mAs). */
+#define CMD_ENERGY_RESPONSE                             180         /*!< Command sends a response frame (mAs). */
+#define CMD_ENERGY_HIGH                                 1080        /*!< Command burns deployment, samples for long time or changes modem (mAs). */
+#define CMD_FLAGS_PUBLIC                                0           /*!< Flags of public commands. */
+#define CMD_FLAGS_PRIVATE                               CMD_FLAG_ENCRYPTED  /*!< Flags of private commands. */
+
+#define COMMAND_TABLE(X) \
+  X(CMD_PING,                    0,        0,                          CMD_FLAGS_PUBLIC | CMD_FLAG_LOW_POWER,                        CMD_ENERGY_RESPONSE, Communication_Command_Ping) \
+  X(CMD_RETRANSMIT,              0,        MAX_STRING_LENGTH,          CMD_FLAGS_PUBLIC | CMD_FLAG_LOW_POWER,                        CMD_ENERGY_RESPONSE, Communication_Command_Retransmit) \
+  X(CMD_RETRANSMIT_CUSTOM,       7 + 1,    7 + MAX_STRING_LENGTH,      CMD_FLAGS_PUBLIC | CMD_FLAG_NO_QUEUE,                         CMD_ENERGY_HIGH,     Communication_Command_Retransmit_Custom) \
+  X(CMD_TRANSMIT_SYSTEM_INFO,    0,        0,                          CMD_FLAGS_PUBLIC | CMD_FLAG_LOW_POWER,                        CMD_ENERGY_RESPONSE, Communication_Command_Transmit_System_Info) \
+  X(CMD_GET_PACKET_INFO,         0,        0,                          CMD_FLAGS_PUBLIC | CMD_FLAG_LOW_POWER,                        CMD_ENERGY_RESPONSE, Communication_Command_Get_Packet_Info) \
+  X(CMD_GET_STATISTICS,          1,        1,                          CMD_FLAGS_PUBLIC | CMD_FLAG_LOW_POWER,                        CMD_ENERGY_RESPONSE, Communication_Command_Get_Statistics) \
+  X(CMD_DEPLOY,                  0,        0,                          CMD_FLAGS_PRIVATE,                                            CMD_ENERGY_HIGH,     Communication_Command_Deploy) \
+  X(CMD_RESTART,                 0,        0,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Restart) \
+  X(CMD_WIPE_EEPROM,             0,        0,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Wipe_EEPROM) \
+  X(CMD_SET_TRANSMIT_ENABLE,     1,        1,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Transmit_Enable) \
+  X(CMD_SET_CALLSIGN,            1,        MAX_STRING_LENGTH - 1,      CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Callsign) \
+  X(CMD_SET_SF_MODE,             1,        1,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_SF_Mode) \
+  X(CMD_SET_MPPT_MODE,           2,        2,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_MPPT_Mode) \
+  X(CMD_SET_LOW_POWER_ENABLE,    1,        1,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Low_Power_Enable) \
+  X(CMD_SET_RECEIVE_WINDOWS,     2,        2,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Receive_Windows) \
+  X(CMD_RECORD_SOLAR_CELLS,      3,        3,                          CMD_FLAGS_PRIVATE,                                            CMD_ENERGY_RESPONSE, Communication_Command_Record_Solar_Cells) \
+  X(CMD_ROUTE,                   0,        MAX_OPT_DATA_LENGTH,        CMD_FLAGS_PRIVATE | CMD_FLAG_NO_QUEUE,                        CMD_ENERGY_RESPONSE, Communication_Command_Route) \
+  X(CMD_GET_SPIN_RATE,           3,        3,                          CMD_FLAGS_PRIVATE,                                            CMD_ENERGY_HIGH,     Communication_Command_Get_Spin_Rate) \
+  X(CMD_START_ADC_BURST,         3,        3,                          CMD_FLAGS_PRIVATE,                                            CMD_ENERGY_HIGH,     Communication_Command_Start_ADC_Burst) \
+  X(CMD_GET_ADC_BURST,           0,        0,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_RESPONSE, Communication_Command_Get_ADC_Burst) \
+  X(CMD_GET_EPOCH_STATISTICS,    2,        2,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_RESPONSE, Communication_Command_Get_Epoch_Statistics) \
+  X(CMD_RESET_EPOCH_STATISTICS,  1,        1,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Reset_Epoch_Statistics) \
+  X(CMD_SET_TASK_SCHEDULE,       5,        5,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Task_Schedule) \
+  X(CMD_SET_LISTEN_MODEM,        1,        1,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Listen_Modem) \
+  X(CMD_QUEUE_COMMAND,           5,        5 + CMD_QUEUE_DATA_LENGTH,  CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER | CMD_FLAG_NO_QUEUE,   CMD_ENERGY_RESPONSE, Communication_Command_Queue_Command) \
+  X(CMD_GET_COMMAND_QUEUE,       0,        1,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER | CMD_FLAG_NO_QUEUE,   CMD_ENERGY_RESPONSE, Communication_Command_Get_Command_Queue) \
+  X(CMD_CLEAR_COMMAND_QUEUE,     1,        1,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER | CMD_FLAG_NO_QUEUE,   CMD_ENERGY_NONE,     Communication_Command_Clear_Command_Queue) \
+  X(CMD_GET_SOLAR_RECORDING,     0,        2,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_RESPONSE, Communication_Command_Get_Solar_Recording) \
+  X(CMD_GET_POST_MORTEM,         0,        0,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_RESPONSE, Communication_Command_Get_Post_Mortem) \
+  X(CMD_SET_SYNC_WORD_PROFILE,   3,        3,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Sync_Word_Profile) \
+  X(CMD_SET_BATTERY_CAPACITY,    2,        2,                          CMD_FLAGS_PRIVATE | CMD_FLAG_LOW_POWER,                       CMD_ENERGY_NONE,     Communication_Command_Set_Battery_Capacity)
+/**
+ * @}
+ */
+
+#endif
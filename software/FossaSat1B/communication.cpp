@@ -1,5 +1,38 @@
 #include "communication.h"
 
+// AES context with the key schedule of encryptionKey, expanded once at startup
+struct AES_ctx aesContext;
+
+// adds min, mean, max and standard deviation of a statistics channel to a frame
+template <typename T>
+static void Communication_Frame_Add_Stats(uint8_t** buffPtr, uint8_t epoch, uint8_t channel) {
+  statsSummary_t stats = Statistics_Get(epoch, channel);
+  Communication_Frame_Add<T>(buffPtr, stats.min, "");
+  Communication_Frame_Add<T>(buffPtr, round(stats.mean), "");
+  Communication_Frame_Add<T>(buffPtr, stats.max, "");
+  Communication_Frame_Add<T>(buffPtr, round(stats.deviation), "");
+}
+
+// adds statistics of channels selected by flags to a frame in channel order, returns number of added bytes
+static uint8_t Communication_Add_Statistics(uint8_t* buff, uint8_t epoch, uint8_t flags) {
+  uint8_t* buffPtr = buff;
+  for(uint8_t channel = 0; channel < STATS_NUM_FLAG_CHANNELS; channel++) {
+    if(!(flags & (1 << channel))) {
+      continue;
+    }
+
+    // type of the channel is taken from the telemetry schema
+    #define TELEMETRY_ADD_STATS(name, type, scale, unit, format, stats, source) \
+      if(stats == channel) { \
+        Communication_Frame_Add_Stats<type>(&buffPtr, epoch, channel); \
+      }
+    TELEMETRY_SCHEMA(TELEMETRY_ADD_STATS)
+    #undef TELEMETRY_ADD_STATS
+  }
+
+  return(buffPtr - buff);
+}
+
 void Communication_Receive_Interrupt() {
   // check interrups are enabled
   if(!interruptsEnabled) {
@@ -10,9 +43,28 @@ void Communication_Receive_Interrupt() {
   dataReceived = true;
 }
 
-int16_t Communication_Set_Modem(uint8_t modem) {
+// mission sync word profile is only used until it expires, expiry too far in the future means total time was reset
+static bool Communication_Mission_Sync_Word() {
+  if(Persistent_Storage_Read<uint8_t>(EEPROM_SYNC_WORD_PROFILE_ADDR) != SYNC_WORD_PROFILE_MISSION) {
+    return(false);
+  }
+  uint32_t now = Timekeeping_Get_Time();
+  uint32_t expiry = Persistent_Storage_Read<uint32_t>(EEPROM_SYNC_WORD_EXPIRY_ADDR);
+  return((now < expiry) && (expiry - now <= (uint32_t)SYNC_WORD_MAX_DURATION * 3600UL));
+}
+
+// FSK frames not starting with the first callsign character are dropped by the radio
+static void Communication_Set_Address_Filter() {
+  if(System_Info_Get_Callsign_Length() > 0) {
+    radio.setNodeAddress(System_Info_Get_Callsign()[0]);
+  } else {
+    radio.disableAddressFiltering();
+  }
+}
+
+static int16_t Communication_Begin(uint8_t modem) {
   int16_t state = ERR_NONE;
-  FOSSASAT_DEBUG_WRITE(modem);
+  bool mission = Communication_Mission_Sync_Word();
 
   // initialize requested modem
   switch (modem) {
@@ -21,7 +73,7 @@ int16_t Communication_Set_Modem(uint8_t modem) {
                             LORA_BANDWIDTH,
                             LORA_SPREADING_FACTOR,
                             LORA_CODING_RATE,
-                            SYNC_WORD,
+                            mission ? SYNC_WORD_MISSION : SYNC_WORD,
                             LORA_OUTPUT_POWER,
                             LORA_PREAMBLE_LENGTH,
                             TCXO_VOLTAGE);
@@ -36,25 +88,76 @@ int16_t Communication_Set_Modem(uint8_t modem) {
                                FSK_OUTPUT_POWER,
                                FSK_PREAMBLE_LENGTH,
                                TCXO_VOLTAGE);
-        uint8_t syncWordFSK[2] = {SYNC_WORD, SYNC_WORD};
-        radio.setSyncWord(syncWordFSK, 2);
+        if(mission) {
+          uint8_t syncWordFSK[SYNC_WORD_MISSION_FSK_LENGTH] = SYNC_WORD_MISSION_FSK;
+          radio.setSyncWord(syncWordFSK, SYNC_WORD_MISSION_FSK_LENGTH);
+        } else {
+          uint8_t syncWordFSK[2] = {SYNC_WORD, SYNC_WORD};
+          radio.setSyncWord(syncWordFSK, 2);
+        }
         radio.setCRC(2);
+
+        // let the radio drop frames for other stations and frames longer than any valid one
+        Communication_Set_Address_Filter();
+        radio.variablePacketLengthMode(MAX_RADIO_BUFFER_LENGTH);
         radio.setDataShaping(FSK_DATA_SHAPING);
         radio.setCurrentLimit(FSK_CURRENT_LIMIT);
       } break;
-    default:
-      return(ERR_UNKNOWN);
   }
 
   radio.setWhitening(true, WHITENING_INITIAL);
+  return(state);
+}
+
+static int16_t Communication_Recover(uint8_t modem, int16_t state) {
+  for(uint8_t tier = RADIO_RECOVERY_RETRY; tier < RADIO_RECOVERY_NUM_TIERS; tier++) {
+    FOSSASAT_DEBUG_PRINT(F("Rcv"));
+    FOSSASAT_DEBUG_PRINTLN(tier);
+    Post_Mortem_Set_Radio_Error(state);
+    Persistent_Storage_Increment_Counter(EEPROM_RADIO_RECOVERY_ADDR + tier*sizeof(uint16_t));
+
+    switch(tier) {
+      case RADIO_RECOVERY_RECONFIGURE:
+        radio.standby();
+        break;
+      case RADIO_RECOVERY_REINIT:
+        // cold sleep does not retain configuration, the radio wakes up on the next SPI transaction
+        radio.sleep(false);
+        delay(1);
+        radio.standby();
+        break;
+      case RADIO_RECOVERY_REBOOT:
+        Pin_Interface_Watchdog_Restart(POST_MORTEM_REASON_RADIO);
+        break;
+    }
+
+    // give the radio more time in each tier, too short for the 50 ms loops of Power_Control_Delay
+    delay((uint32_t)RADIO_RECOVERY_BACKOFF << tier);
+    state = Communication_Begin(modem);
+    if(state == ERR_NONE) {
+      break;
+    }
+  }
+
+  return(state);
+}
+
+int16_t Communication_Set_Modem(uint8_t modem) {
+  FOSSASAT_DEBUG_WRITE(modem);
+  if((modem != MODEM_LORA) && (modem != MODEM_FSK)) {
+    return(ERR_UNKNOWN);
+  }
+
+  // initialize requested modem
+  int16_t state = Communication_Begin(modem);
 
   // handle possible error codes
   FOSSASAT_DEBUG_PRINT(F("Init "));
   FOSSASAT_DEBUG_PRINTLN(state);
   FOSSASAT_DEBUG_DELAY(10);
   if (state != ERR_NONE) {
-    // radio chip failed, restart
-    Pin_Interface_Watchdog_Restart();
+    // radio chip failed, escalate recovery until it works again
+    state = Communication_Recover(modem, state);
   }
 
   // set spreading factor
@@ -106,7 +209,7 @@ int16_t Communication_Set_Configuration(uint8_t* optData, uint8_t optDataLen) {
                                bws[optData[0]],
                                optData[1],
                                optData[2],
-                               SYNC_WORD,
+                               Communication_Mission_Sync_Word() ? SYNC_WORD_MISSION : SYNC_WORD,
                                optData[6],
                                LORA_CURRENT_LIMIT,
                                preambleLength);
@@ -123,31 +226,26 @@ void Communication_Send_Morse_Beacon(float battVoltage) {
   // initialize Morse client
   morse.begin(FSK_CARRIER_FREQUENCY, MORSE_SPEED);
 
-  // read callsign
-  uint8_t callsignLen = Persistent_Storage_Read<uint8_t>(EEPROM_CALLSIGN_LEN_ADDR);
-  char callsign[MAX_STRING_LENGTH + 1];
-  System_Info_Get_Callsign(callsign, callsignLen);
+  // get callsign
+  uint8_t callsignLen = System_Info_Get_Callsign_Length();
+  const char* callsign = System_Info_Get_Callsign();
 
   // send start signals
   for(int8_t i = 0; i < MORSE_PREAMBLE_LENGTH; i++) {
     morse.startSignal();
-    Pin_Interface_Watchdog_Heartbeat();
   }
 
   // send callsign
-  for(uint8_t i = 0; i < callsignLen - 1; i++) {
+  for(uint8_t i = 0; i < callsignLen; i++) {
     morse.print(callsign[i]);
-    Pin_Interface_Watchdog_Heartbeat();
   }
 
   // space
   morse.print(' ');
-  Pin_Interface_Watchdog_Heartbeat();
 
   // send battery voltage code
   char code = 'A' + (uint8_t)((battVoltage - MORSE_BATTERY_MIN) / MORSE_BATTERY_STEP);
   morse.println(code);
-  Pin_Interface_Watchdog_Heartbeat();
 }
 
 void Communication_CW_Beep(uint32_t len) {
@@ -157,81 +255,21 @@ void Communication_CW_Beep(uint32_t len) {
 }
 
 void Communication_Send_System_Info() {
-  // build response frame
-  static const uint8_t optDataLen = 6*sizeof(uint8_t) + 3*sizeof(int16_t) + sizeof(uint16_t) + sizeof(int8_t) + sizeof(uint32_t);
-  uint8_t optData[optDataLen];
+  // build response frame, all fields are read and packed as given by the telemetry schema
+  uint8_t optData[TELEMETRY_SYSTEM_INFO_LENGTH];
   uint8_t* optDataPtr = optData;
-
-  #ifdef ENABLE_INA226
-    uint8_t batteryVoltage = Power_Control_Get_Battery_Voltage() * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-  #else
-    uint8_t batteryVoltage = 4.02 * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-  #endif
-  Communication_Frame_Add<uint8_t>(&optDataPtr, batteryVoltage, "batV");
-  Persistent_Storage_Update_Stats<uint8_t>(EEPROM_BATTERY_VOLTAGE_STATS_ADDR, batteryVoltage);
-
-  #ifdef ENABLE_INA226
-    int16_t batteryChargingCurrent = Power_Control_Get_Charging_Current() * (CURRENT_UNIT / CURRENT_MULTIPLIER);
-  #else
-    int16_t batteryChargingCurrent = 0.056 * (CURRENT_UNIT / CURRENT_MULTIPLIER);
-  #endif
-  Communication_Frame_Add<int16_t>(&optDataPtr, batteryChargingCurrent, "batChI");
-  Persistent_Storage_Update_Stats<int16_t>(EEPROM_CHARGING_CURRENT_STATS_ADDR, batteryChargingCurrent);
-
-  #ifdef ENABLE_INA226
-    uint8_t batteryChargingVoltage = Power_Control_Get_Charging_Voltage() * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-  #else
-    uint8_t batteryChargingVoltage = 3.82 * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-  #endif
-  Communication_Frame_Add<uint8_t>(&optDataPtr, batteryChargingVoltage, "batChV");
-  Persistent_Storage_Update_Stats<uint8_t>(EEPROM_CHARGING_VOLTAGE_STATS_ADDR, batteryChargingVoltage);
-
-  // set uptimeCounter
-  uint32_t uptimeCounter = Persistent_Storage_Read<uint32_t>(EEPROM_UPTIME_COUNTER_ADDR);
-  Communication_Frame_Add(&optDataPtr, uptimeCounter, "up");
-
-  // set powerConfig variable
-  Power_Control_Load_Configuration();
+  #define TELEMETRY_ADD_FIELD(name, type, scale, unit, format, stats, source) \
+    Communication_Frame_Add<type>(&optDataPtr, (source) * (scale), #name);
+  TELEMETRY_SCHEMA(TELEMETRY_ADD_FIELD)
+  #undef TELEMETRY_ADD_FIELD
   FOSSASAT_DEBUG_PRINTLN(powerConfig.val, BIN);
-  memcpy(optDataPtr, &powerConfig.val, sizeof(uint8_t));
-  optDataPtr += sizeof(uint8_t);
-
-  // set resetCounter variable
-  uint16_t resetCounter = Persistent_Storage_Read<uint16_t>(EEPROM_RESTART_COUNTER_ADDR);
-  Communication_Frame_Add(&optDataPtr, resetCounter, "rst");
-
-  uint8_t solarCellAVoltage = Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_A_VOLTAGE_PIN) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-  Communication_Frame_Add<uint8_t>(&optDataPtr, solarCellAVoltage, "sAV");
-  Persistent_Storage_Update_Stats<uint8_t>(EEPROM_CELL_A_VOLTAGE_STATS_ADDR, solarCellAVoltage);
-
-  // set solarCellBVoltage variable
-  uint8_t solarCellBVoltage = Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_B_VOLTAGE_PIN) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-  Communication_Frame_Add<uint8_t>(&optDataPtr, solarCellBVoltage, "sBV");
-  Persistent_Storage_Update_Stats<uint8_t>(EEPROM_CELL_B_VOLTAGE_STATS_ADDR, solarCellBVoltage);
-
-  // set solarCellCVoltage variable
-  uint8_t solarCellCVoltage = Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_C_VOLTAGE_PIN) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-  Communication_Frame_Add<uint8_t>(&optDataPtr, solarCellCVoltage, "sCV");
-  Persistent_Storage_Update_Stats<uint8_t>(EEPROM_CELL_C_VOLTAGE_STATS_ADDR, solarCellCVoltage);
-
-  // set batteryTemperature variable
-  int16_t batteryTemperature = Pin_Interface_Read_Temperature(BATTERY_TEMP_SENSOR_ADDR) * (TEMPERATURE_UNIT / TEMPERATURE_MULTIPLIER);
-  Communication_Frame_Add<int16_t>(&optDataPtr, batteryTemperature, "batT");
-  Persistent_Storage_Update_Stats<int16_t>(EEPROM_BATTERY_TEMP_STATS_ADDR, batteryTemperature);
-
-  // set boardTemperature variable
-  int16_t boardTemperature = Pin_Interface_Read_Temperature(BOARD_TEMP_SENSOR_ADDR) * (TEMPERATURE_UNIT / TEMPERATURE_MULTIPLIER);
-  Communication_Frame_Add<int16_t>(&optDataPtr, boardTemperature, "brdT");
-  Persistent_Storage_Update_Stats<int16_t>(EEPROM_BOARD_TEMP_STATS_ADDR, boardTemperature);
-
-  // set mcuTemperature variable (read twice since first value is often nonsense)
-  Pin_Interface_Read_Temperature_Internal();
-  int8_t mcuTemperature = Pin_Interface_Read_Temperature_Internal();
-  Communication_Frame_Add<int8_t>(&optDataPtr, mcuTemperature, "mcuT");
-  Persistent_Storage_Update_Stats<int8_t>(EEPROM_MCU_TEMP_STATS_ADDR, mcuTemperature);
 
   // send as raw bytes
-  Communication_Send_Response(RESP_SYSTEM_INFO, optData, optDataLen);
+  Communication_Send_Response(RESP_SYSTEM_INFO, optData, TELEMETRY_SYSTEM_INFO_LENGTH);
+}
+
+void Communication_Init_Encryption() {
+  AES_init_ctx(&aesContext, encryptionKey);
 }
 
 void Communication_Acknowledge(uint8_t functionId, uint8_t result) {
@@ -239,6 +277,46 @@ void Communication_Acknowledge(uint8_t functionId, uint8_t result) {
   Communication_Send_Response(RESP_ACKNOWLEDGE, optData, 2);
 }
 
+// NACK tokens used and time of the last refill of each error class
+uint8_t nackTokensUsed[NACK_NUM_CLASSES];
+uint32_t nackRefillTime[NACK_NUM_CLASSES];
+
+static bool Communication_Take_Nack_Token(uint8_t nackClass) {
+  // regain tokens for the time that has passed
+  uint32_t now = Timekeeping_Get_Uptime();
+  uint32_t regained = (now - nackRefillTime[nackClass]) / NACK_REFILL_PERIOD;
+  if(regained >= nackTokensUsed[nackClass]) {
+    nackTokensUsed[nackClass] = 0;
+    nackRefillTime[nackClass] = now;
+  } else {
+    nackTokensUsed[nackClass] -= regained;
+    nackRefillTime[nackClass] += regained * NACK_REFILL_PERIOD;
+  }
+
+  if(nackTokensUsed[nackClass] >= NACK_BUCKET_SIZE) {
+    return(false);
+  }
+  nackTokensUsed[nackClass]++;
+  return(true);
+}
+
+void Communication_Nack(uint8_t result) {
+  // all invalid frames are counted, even when not answered
+  Persistent_Storage_Increment_Frame_Counter(false);
+  uint8_t nackClass = result - NACK_CALLSIGN;
+  if(nackClass >= NACK_NUM_CLASSES) {
+    return;
+  }
+  nackCounters[nackClass]++;
+
+  // frames for other stations are never answered
+  if((result == NACK_CALLSIGN) || !Communication_Take_Nack_Token(nackClass)) {
+    FOSSASAT_DEBUG_PRINTLN(F("NSup"));
+    return;
+  }
+  Communication_Acknowledge(0xFF, result);
+}
+
 void Communication_Process_Packet() {
   /*FOSSASAT_DEBUG_PRINT("Communication_Process_Packet ");
   FOSSASAT_DEBUG_PRINTLN(freeRam());
@@ -247,13 +325,21 @@ void Communication_Process_Packet() {
   // disable interrupts
   interruptsEnabled = false;
 
-  // read data
+  // check length from packet status first, frames that can't be valid are not read at all
   size_t len = radio.getPacketLength();
-  if(len == 0) {
+  if((len <= System_Info_Get_Callsign_Length()) || (len > MAX_RADIO_BUFFER_LENGTH)) {
+    FOSSASAT_DEBUG_PRINT(F("LenRej "));
+    FOSSASAT_DEBUG_PRINTLN(len);
+    if(len > 0) {
+      // most likely another station, so it is treated as callsign mismatch
+      Communication_Nack(NACK_CALLSIGN);
+    }
     dataReceived = false;
     interruptsEnabled = true;
     return;
   }
+
+  // read data
   uint8_t frame[MAX_RADIO_BUFFER_LENGTH];
   int16_t state = radio.readData(frame, len);
 
@@ -263,24 +349,13 @@ void Communication_Process_Packet() {
     FOSSASAT_DEBUG_PRINTLN(len);
     FOSSASAT_DEBUG_PRINT_BUFF(frame, len);
 
-    // check callsign
-    uint8_t callsignLen = Persistent_Storage_Read<uint8_t>(EEPROM_CALLSIGN_LEN_ADDR);
-    char callsign[MAX_STRING_LENGTH + 1];
-    System_Info_Get_Callsign(callsign, callsignLen);
-    if(memcmp(frame, (uint8_t*)callsign, callsignLen - 1) == 0) {
-      // check passed
-      Comunication_Parse_Frame(frame, len);
-    } else {
-      FOSSASAT_DEBUG_PRINTLN(F("CErr"));
-      Persistent_Storage_Increment_Frame_Counter(false);
-      Communication_Acknowledge(0xFF, 0x01);
-    }
+    // parse the frame in place, callsign is checked there
+    Comunication_Parse_Frame(frame, len);
 
   } else {
     FOSSASAT_DEBUG_PRINT(F("RxErr "));
     FOSSASAT_DEBUG_PRINT(state);
-    Persistent_Storage_Increment_Frame_Counter(false);
-    Communication_Acknowledge(0xFF, 0x02);
+    Communication_Nack(NACK_RX_ERROR);
   }
 
   // reset flag
@@ -290,418 +365,548 @@ void Communication_Process_Packet() {
   interruptsEnabled = true;
 }
 
-void Comunication_Parse_Frame(uint8_t* frame, size_t len) {
-  /*FOSSASAT_DEBUG_PRINT("Comunication_Parse_Frame ");
-  FOSSASAT_DEBUG_PRINTLN(freeRam());
-  FOSSASAT_DEBUG_DELAY(100);*/
-
-  // read callsign from EEPROM
-  uint8_t callsignLen = Persistent_Storage_Read<uint8_t>(EEPROM_CALLSIGN_LEN_ADDR);
-  char callsign[MAX_STRING_LENGTH + 1];
-  System_Info_Get_Callsign(callsign, callsignLen);
-
-  // get functionID
-  int16_t functionId = FCP_Get_FunctionID(callsign, frame, len);
-  if(functionId < 0) {
-    FOSSASAT_DEBUG_PRINT(F("IdErr"));
-    FOSSASAT_DEBUG_PRINTLN(functionId);
-    Persistent_Storage_Increment_Frame_Counter(false);
-    Communication_Acknowledge(0xFF, 0x03);
-    return;
+uint8_t Communication_Parse_View(uint8_t* frame, size_t len, frameView_t* view) {
+  // reject foreign frames first
+  if(!System_Info_Match_Callsign(frame, len)) {
+    return(NACK_CALLSIGN);
   }
-  FOSSASAT_DEBUG_PRINT(F("FID="));
-  FOSSASAT_DEBUG_PRINTLN(functionId, HEX);
 
-  // check encryption
-  int16_t optDataLen = 0;
-  uint8_t optData[MAX_OPT_DATA_LENGTH];
-  if((functionId >= PRIVATE_OFFSET) && (functionId <= (PRIVATE_OFFSET + NUM_PRIVATE_COMMANDS))) {
-    // frame contains encrypted data, decrypt
+  // get function ID, it follows the callsign
+  uint8_t callsignLen = System_Info_Get_Callsign_Length() + 1;
+  if(len < callsignLen) {
+    return(NACK_FUNCTION_ID);
+  }
+  view->optData = frame + callsignLen;
+  view->optDataLen = len - callsignLen;
 
-    // get optional data length
-    optDataLen = FCP_Get_OptData_Length(callsign, frame, len, encryptionKey, password);
-    if(optDataLen < 0) {
-      FOSSASAT_DEBUG_PRINT(F("DcErr"));
-      FOSSASAT_DEBUG_PRINTLN(optDataLen);
+  // only function IDs from the command table are accepted, the entry is kept for execution
+  if(!Communication_Get_Command(frame[callsignLen - 1], &view->cmd)) {
+    return(NACK_UNKNOWN_ID);
+  }
+  if(view->cmd.flags & CMD_FLAG_ENCRYPTED) {
+    // encrypted data, view covers the ciphertext until it is decrypted
+    return(0x00);
+  }
 
-      // decryption failed, increment invalid frame counter and return
-      Persistent_Storage_Increment_Frame_Counter(false);
-      Communication_Acknowledge(0xFF, 0x04);
-      return;
-    }
+  // no optional data at all, or length byte followed by exactly that many bytes
+  if(view->optDataLen == 0) {
+    return(0x00);
+  }
+  if(frame[callsignLen] != view->optDataLen - 1) {
+    return(NACK_LENGTH);
+  }
+  view->optData++;
+  view->optDataLen--;
+  return(0x00);
+}
 
-    // get optional data
-    if(optDataLen > 0) {
-      FCP_Get_OptData(callsign, frame, len, optData, encryptionKey, password);
-    }
+static int16_t Communication_Decrypt_View(frameView_t* view) {
+  int16_t len = Crypto_Decrypt_Section(&aesContext, password, view->optData, view->optDataLen, &view->optData);
+  if(len >= 0) {
+    view->optDataLen = len;
+  }
+  return(len);
+}
 
-  } else if(functionId < PRIVATE_OFFSET) {
-    // no decryption necessary
+void Comunication_Parse_Frame(uint8_t* frame, size_t len) {
+  /*FOSSASAT_DEBUG_PRINT("Comunication_Parse_Frame ");
+  FOSSASAT_DEBUG_PRINTLN(freeRam());
+  FOSSASAT_DEBUG_DELAY(100);*/
 
-    // get optional data length
-    optDataLen = FCP_Get_OptData_Length(callsign, frame, len);
-    if(optDataLen < 0) {
-      // optional data extraction failed,
-      FOSSASAT_DEBUG_PRINT(F("LenErr"));
-      FOSSASAT_DEBUG_PRINTLN(optDataLen);
+  // validate the frame once, optional data is not copied
+  frameView_t view;
+  uint8_t result = Communication_Parse_View(frame, len, &view);
+  if(result == 0x00) {
+    FOSSASAT_DEBUG_PRINT(F("FID="));
+    FOSSASAT_DEBUG_PRINTLN(view.cmd.id, HEX);
 
-      // increment invalid frame counter
-      Persistent_Storage_Increment_Frame_Counter(false);
-      Communication_Acknowledge(0xFF, 0x05);
-      return;
+    // frame contains encrypted data, decrypt
+    if((view.cmd.flags & CMD_FLAG_ENCRYPTED) && (Communication_Decrypt_View(&view) < 0)) {
+      result = NACK_DECRYPTION;
     }
+  }
 
-    // get optional data
-    if(optDataLen > 0) {
-      FCP_Get_OptData(callsign, frame, len, optData);
-    }
-  } else {
-    // unknown function ID
-    FOSSASAT_DEBUG_PRINT(F("UID"));
-    FOSSASAT_DEBUG_PRINTLN(functionId, HEX);
-    Persistent_Storage_Increment_Frame_Counter(false);
-    Communication_Acknowledge(0xFF, 0x06);
+  if(result != 0x00) {
+    // invalid frame
+    FOSSASAT_DEBUG_PRINT(F("FrmErr"));
+    FOSSASAT_DEBUG_PRINTLN(result);
+    Communication_Nack(result);
     return;
   }
 
   // check optional data presence
-  if(optDataLen > 0) {
+  if(view.optDataLen > 0) {
     // execute with optional data
     FOSSASAT_DEBUG_PRINT(F("optLen="));
-    FOSSASAT_DEBUG_PRINTLN(optDataLen);
-    FOSSASAT_DEBUG_PRINT_BUFF(optData, (uint8_t)optDataLen);
-    Communication_Execute_Function(functionId, optData, optDataLen);
+    FOSSASAT_DEBUG_PRINTLN(view.optDataLen);
+    FOSSASAT_DEBUG_PRINT_BUFF(view.optData, view.optDataLen);
+    Communication_Execute_Function(view.cmd, view.optData, view.optDataLen);
 
   } else {
     // execute without optional data
-    Communication_Execute_Function(functionId);
+    Communication_Execute_Function(view.cmd);
   }
 }
 
-void Communication_Execute_Function(uint8_t functionId, uint8_t* optData, size_t optDataLen) {
-  /*FOSSASAT_DEBUG_PRINT("Communication_Execute_Function ");
-  FOSSASAT_DEBUG_PRINTLN(freeRam());
-  FOSSASAT_DEBUG_DELAY(100);*/
+static void Communication_Command_Ping(uint8_t*, uint8_t) {
+  // send pong
+  Communication_Send_Response(RESP_PONG);
+}
 
-  // increment valid frame counter
-  Persistent_Storage_Increment_Frame_Counter(true);
+static void Communication_Command_Retransmit(uint8_t* optData, uint8_t optDataLen) {
+  // respond with the requested data
+  Communication_Send_Response(RESP_REPEATED_MESSAGE, optData, optDataLen);
+}
 
-  // acknowledge frame
-  Communication_Acknowledge(functionId, 0x00);
+static void Communication_Command_Retransmit_Custom(uint8_t* optData, uint8_t optDataLen) {
+  // change modem configuration
+  int16_t state = Communication_Set_Configuration(optData, optDataLen);
 
-  // execute function based on ID
-  switch(functionId) {
-    case CMD_PING:
-      // send pong
-      Communication_Send_Response(RESP_PONG);
-      break;
+  // check if the change was successful
+  if(state != ERR_NONE) {
+    FOSSASAT_DEBUG_PRINT(F("CfgErr"));
+    FOSSASAT_DEBUG_PRINTLN(state);
+  } else {
+    // configuration changed successfully, transmit response
+    Communication_Send_Response(RESP_REPEATED_MESSAGE_CUSTOM, optData + 7, optDataLen - 7, true);
+  }
+}
 
-    case CMD_RETRANSMIT: {
-        // check message length
-        if (optDataLen <= MAX_STRING_LENGTH) {
-          // respond with the requested data
-          Communication_Send_Response(RESP_REPEATED_MESSAGE, optData, optDataLen);
-        }
-      } break;
+static void Communication_Command_Transmit_System_Info(uint8_t*, uint8_t) {
+  // send system info via LoRa
+  Communication_Send_System_Info();
+}
 
-    case CMD_RETRANSMIT_CUSTOM: {
-        // check message length
-        if((optDataLen >= 8) && (optDataLen <= MAX_STRING_LENGTH + 7)) {
-          // change modem configuration
-          int16_t state = Communication_Set_Configuration(optData, optDataLen);
-
-          // check if the change was successful
-          if(state != ERR_NONE) {
-            FOSSASAT_DEBUG_PRINT(F("CfgErr"));
-            FOSSASAT_DEBUG_PRINTLN(state);
-          } else {
-            // configuration changed successfully, transmit response
-            Communication_Send_Response(RESP_REPEATED_MESSAGE_CUSTOM, optData + 7, optDataLen - 7, true);
-          }
-        }
-      } break;
+static void Communication_Command_Get_Packet_Info(uint8_t*, uint8_t) {
+  // get last packet info and send it
+  static const uint8_t respOptDataLen = 2*sizeof(uint8_t) + (7 + NACK_NUM_CLASSES)*sizeof(uint16_t);
+  uint8_t respOptData[respOptDataLen];
+  uint8_t* respOptDataPtr = respOptData;
 
-    case CMD_TRANSMIT_SYSTEM_INFO:
-      // send system info via LoRa
-      Communication_Send_System_Info();
-      break;
+  // SNR
+  int8_t snr = (int8_t)(radio.getSNR() * 4.0);
+  Communication_Frame_Add(&respOptDataPtr, snr, "SNR");
 
-    case CMD_GET_PACKET_INFO: {
-        // get last packet info and send it
-        static const uint8_t respOptDataLen = 2*sizeof(uint8_t) + 4*sizeof(uint16_t);
-        uint8_t respOptData[respOptDataLen];
-        uint8_t* respOptDataPtr = respOptData;
+  // RSSI
+  uint8_t rssi = (uint8_t)(radio.getRSSI() * -2.0);
+  Communication_Frame_Add(&respOptDataPtr, rssi, "RSSI");
 
-        // SNR
-        int8_t snr = (int8_t)(radio.getSNR() * 4.0);
-        Communication_Frame_Add(&respOptDataPtr, snr, "SNR");
+  uint16_t loraValid = logRecord.frameCounters[0];
+  Communication_Frame_Add(&respOptDataPtr, loraValid, "Lv");
 
-        // RSSI
-        uint8_t rssi = (uint8_t)(radio.getRSSI() * -2.0);
-        Communication_Frame_Add(&respOptDataPtr, rssi, "RSSI");
+  uint16_t loraInvalid = logRecord.frameCounters[1];
+  Communication_Frame_Add(&respOptDataPtr, loraInvalid, "Li");
 
-        uint16_t loraValid = Persistent_Storage_Read<uint16_t>(EEPROM_LORA_VALID_COUNTER_ADDR);
-        Communication_Frame_Add(&respOptDataPtr, loraValid, "Lv");
+  uint16_t fskValid = logRecord.frameCounters[2];
+  Communication_Frame_Add(&respOptDataPtr, fskValid, "Fv");
 
-        uint16_t loraInvalid = Persistent_Storage_Read<uint16_t>(EEPROM_LORA_INVALID_COUNTER_ADDR);
-        Communication_Frame_Add(&respOptDataPtr, loraInvalid, "Li");
+  uint16_t fskInvalid = logRecord.frameCounters[3];
+  Communication_Frame_Add(&respOptDataPtr, fskInvalid, "Fi");
 
-        uint16_t fskValid = Persistent_Storage_Read<uint16_t>(EEPROM_FSK_VALID_COUNTER_ADDR);
-        Communication_Frame_Add(&respOptDataPtr, fskValid, "Fv");
+  // transmissions sent at reduced power and refused due to low battery
+  Communication_Frame_Add(&respOptDataPtr, txAdmissionCounters[TX_ADMIT_REDUCED], "Tr");
+  Communication_Frame_Add(&respOptDataPtr, txAdmissionCounters[TX_ADMIT_REFUSED], "Tx");
 
-        uint16_t fskInvalid = Persistent_Storage_Read<uint16_t>(EEPROM_FSK_INVALID_COUNTER_ADDR);
-        Communication_Frame_Add(&respOptDataPtr, fskInvalid, "Fi");
+  // invalid frames of each error class since restart
+  for(uint8_t i = 0; i < NACK_NUM_CLASSES; i++) {
+    Communication_Frame_Add(&respOptDataPtr, nackCounters[i], "N");
+  }
 
-        Communication_Send_Response(RESP_PACKET_INFO, respOptData, respOptDataLen);
-      } break;
+  // valid commands refused since restart
+  Communication_Frame_Add(&respOptDataPtr, commandRefusals, "Cr");
 
-    case CMD_GET_STATISTICS: {
-        // check optional data is exactly 1 byte
-        if(Communication_Check_OptDataLen(1, optDataLen)) {
-          // response will have maximum of 34 bytes if all stats are included
-          uint8_t respOptData[34];
-          uint8_t respOptDataLen = 1;
-          uint8_t* respOptDataPtr = respOptData;
-
-          // copy stat flags
-          uint8_t flags = optData[0];
-          memcpy(respOptDataPtr, &flags, sizeof(uint8_t));
-          respOptDataPtr += sizeof(uint8_t);
-
-          // get required stats from EEPROM
-          if(flags & 0x01) {
-            // charging voltage
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CHARGING_VOLTAGE_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CHARGING_VOLTAGE_STATS_ADDR + 1), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CHARGING_VOLTAGE_STATS_ADDR + 2), "");
-            respOptDataLen += 3;
-          }
-
-          if(flags& 0x02) {
-            // charging current
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_CHARGING_CURRENT_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_CHARGING_CURRENT_STATS_ADDR + 2), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_CHARGING_CURRENT_STATS_ADDR + 4), "");
-            respOptDataLen += 6;
-          }
-
-          if(flags & 0x04) {
-            // battery voltage
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_BATTERY_VOLTAGE_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_BATTERY_VOLTAGE_STATS_ADDR + 1), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_BATTERY_VOLTAGE_STATS_ADDR + 2), "");
-            respOptDataLen += 3;
-          }
-
-          if(flags & 0x08) {
-            // cell A voltage
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_A_VOLTAGE_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_A_VOLTAGE_STATS_ADDR + 1), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_A_VOLTAGE_STATS_ADDR + 2), "");
-            respOptDataLen += 3;
-          }
-
-          if(flags & 0x10) {
-            // cell B voltage
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_B_VOLTAGE_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_B_VOLTAGE_STATS_ADDR + 1), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_B_VOLTAGE_STATS_ADDR + 2), "");
-            respOptDataLen += 3;
-          }
-
-          if(flags & 0x20) {
-            // cell C voltage
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_C_VOLTAGE_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_C_VOLTAGE_STATS_ADDR + 1), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<uint8_t>(EEPROM_CELL_C_VOLTAGE_STATS_ADDR + 2), "");
-            respOptDataLen += 3;
-          }
-
-          if(flags & 0x40) {
-            // battery temperature
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_BATTERY_TEMP_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_BATTERY_TEMP_STATS_ADDR + 2), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_BATTERY_TEMP_STATS_ADDR + 4), "");
-            respOptDataLen += 6;
-          }
-
-          if(flags & 0x80) {
-            // board temperature
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_BOARD_TEMP_STATS_ADDR), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_BOARD_TEMP_STATS_ADDR + 2), "");
-            Communication_Frame_Add(&respOptDataPtr, Persistent_Storage_Read<int16_t>(EEPROM_BOARD_TEMP_STATS_ADDR + 4), "");
-            respOptDataLen += 6;
-          }
-
-          // send response
-          Communication_Send_Response(RESP_STATISTICS, respOptData, respOptDataLen);
-        }
-      } break;
+  Communication_Send_Response(RESP_PACKET_INFO, respOptData, respOptDataLen);
+}
 
-    // private function IDs
-    case CMD_DEPLOY: {
-        // run deployment sequence
-        Deployment_Deploy();
+static void Communication_Command_Get_Statistics(uint8_t* optData, uint8_t) {
+  // response will have maximum of TELEMETRY_STATS_LENGTH + 1 bytes if all stats are included
+  uint8_t respOptData[TELEMETRY_STATS_LENGTH + 1];
+  uint8_t respOptDataLen = 1;
+  uint8_t* respOptDataPtr = respOptData;
 
-        // get deployment counter value and send it
-        uint8_t counter = Persistent_Storage_Read<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR);
-        Communication_Send_Response(RESP_DEPLOYMENT_STATE, &counter, 1);
-      } break;
+  // copy stat flags
+  uint8_t flags = optData[0];
+  memcpy(respOptDataPtr, &flags, sizeof(uint8_t));
+  respOptDataPtr += sizeof(uint8_t);
 
-    case CMD_RESTART:
-      // restart satellite
-      Pin_Interface_Watchdog_Restart();
-      break;
+  // get required stats
+  respOptDataLen += Communication_Add_Statistics(respOptDataPtr, STATS_EPOCH_LIFETIME, flags);
 
-    case CMD_WIPE_EEPROM:
-      // wipe EEPROM and reset all EEPROM variables to default values
-      Persistent_Storage_Wipe();
-      break;
+  // send response
+  Communication_Send_Response(RESP_STATISTICS, respOptData, respOptDataLen);
+}
 
-    case CMD_SET_TRANSMIT_ENABLE: {
-        // check optional data is exactly 1 byte
-        if(Communication_Check_OptDataLen(1, optDataLen)) {
-          // load power config from EEPROM
-          Power_Control_Load_Configuration();
+static void Communication_Command_Deploy(uint8_t*, uint8_t) {
+  // run deployment sequence
+  Deployment_Deploy();
 
-          // update transmit enable flag
-          powerConfig.bits.transmitEnabled = optData[0];
+  // get deployment counter value and send it
+  uint8_t counter = Persistent_Storage_Read<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR);
+  Communication_Send_Response(RESP_DEPLOYMENT_STATE, &counter, 1);
+}
 
-          // save power config from EEPROM
-          Power_Control_Save_Configuration();
-        }
-      } break;
+static void Communication_Command_Restart(uint8_t*, uint8_t) {
+  // restart satellite
+  Pin_Interface_Watchdog_Restart(POST_MORTEM_REASON_COMMAND);
+}
 
-    case CMD_SET_CALLSIGN: {
-        // check optional data is less than limit
-        if(optDataLen <= MAX_STRING_LENGTH) {
-          // get callsign from frame
-          char newCallsign[MAX_STRING_LENGTH + 1];
-          memcpy(newCallsign, optData, optDataLen);
-          newCallsign[optDataLen] = '\0';
-
-          // update callsign
-          System_Info_Set_Callsign(newCallsign);
-          FOSSASAT_DEBUG_PRINTLN(newCallsign);
-        }
-      } break;
+static void Communication_Command_Wipe_EEPROM(uint8_t*, uint8_t) {
+  // wipe EEPROM and reset all EEPROM variables to default values
+  Persistent_Storage_Wipe();
+}
 
-    case CMD_SET_SF_MODE: {
-        // check optional data is exactly 1 byte
-        if(Communication_Check_OptDataLen(1, optDataLen)) {
-          // update spreading factor mode
-          spreadingFactorMode = optData[0];
-          Communication_Set_SpreadingFactor(spreadingFactorMode);
-        }
-      } break;
+static void Communication_Command_Set_Transmit_Enable(uint8_t* optData, uint8_t) {
+  // load power config from EEPROM
+  Power_Control_Load_Configuration();
 
-    case CMD_SET_MPPT_MODE: {
-        // check optional data is exactly 2 bytes
-        if(Communication_Check_OptDataLen(2, optDataLen)) {
-          // load power config from EEPROM
-          Power_Control_Load_Configuration();
+  // update transmit enable flag
+  powerConfig.bits.transmitEnabled = optData[0];
 
-          // update MPPT mode
-          powerConfig.bits.mpptTempSwitchEnabled = optData[0];
-          powerConfig.bits.mpptKeepAliveEnabled = optData[1];
+  // save power config from EEPROM
+  Power_Control_Save_Configuration();
+}
 
-          // save power config from EEPROM
-          Power_Control_Save_Configuration();
-        }
-      } break;
+static void Communication_Command_Set_Callsign(uint8_t* optData, uint8_t optDataLen) {
+  // update callsign straight from the frame
+  System_Info_Set_Callsign((char*)optData, optDataLen);
+  FOSSASAT_DEBUG_PRINT_BUFF(optData, optDataLen);
 
-    case CMD_SET_LOW_POWER_ENABLE: {
-        // check optional data is exactly 1 byte
-        if(Communication_Check_OptDataLen(1, optDataLen)) {
-          // load power config from EEPROM
-          Power_Control_Load_Configuration();
+  // node address follows the callsign
+  if(currentModem == MODEM_FSK) {
+    Communication_Set_Address_Filter();
+  }
+}
 
-          // update low power enable flag
-          powerConfig.bits.lowPowerModeEnabled = optData[0];
+static void Communication_Command_Set_SF_Mode(uint8_t* optData, uint8_t) {
+  // update spreading factor mode
+  spreadingFactorMode = optData[0];
+  Communication_Set_SpreadingFactor(spreadingFactorMode);
+}
 
-          // save power config from EEPROM
-          Power_Control_Save_Configuration();
-        }
-      } break;
+static void Communication_Command_Set_MPPT_Mode(uint8_t* optData, uint8_t) {
+  // load power config from EEPROM
+  Power_Control_Load_Configuration();
 
-    case CMD_SET_RECEIVE_WINDOWS: {
-      // check optional data is exactly 2 bytes
-      if(Communication_Check_OptDataLen(2, optDataLen)) {
-        // set FSK receive length
-        Persistent_Storage_Write<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR, optData[0]);
+  // update MPPT mode
+  powerConfig.bits.mpptTempSwitchEnabled = optData[0];
+  powerConfig.bits.mpptKeepAliveEnabled = optData[1];
 
-        // set LoRa receive length
-        Persistent_Storage_Write<uint8_t>(EEPROM_LORA_RECEIVE_LEN_ADDR, optData[1]);
+  // save power config from EEPROM
+  Power_Control_Save_Configuration();
+}
 
-        // check if there will be still some receive window open
-        if((Persistent_Storage_Read<uint8_t>(EEPROM_LORA_RECEIVE_LEN_ADDR) == 0) && (Persistent_Storage_Read<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR) == 0)) {
-          FOSSASAT_DEBUG_PRINT(F("Res FSK"));
-          Persistent_Storage_Write<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR, FSK_RECEIVE_WINDOW_LENGTH);
-        }
-      }
-    } break;
+static void Communication_Command_Set_Low_Power_Enable(uint8_t* optData, uint8_t) {
+  // load power config from EEPROM
+  Power_Control_Load_Configuration();
 
-    case CMD_RECORD_SOLAR_CELLS: {
-      // check optional data is exactly 3 bytes
-      if(Communication_Check_OptDataLen(3, optDataLen)) {
-        uint16_t numSamples = optData[0];
+  // update low power enable flag
+  powerConfig.bits.lowPowerModeEnabled = optData[0];
 
-        // check number of samples is less than limit
-        if(numSamples > 40) {
-          FOSSASAT_DEBUG_PRINT(F(">40"));
-          break;
-        }
+  // save power config from EEPROM
+  Power_Control_Save_Configuration();
+}
 
-        // get sample period
-        uint16_t period = 0;
-        memcpy(&period, optData + 1, 2);
-        FOSSASAT_DEBUG_PRINT(F("Rec"));
-
-        // record all data
-        uint8_t respoOptDataLen = 3 * numSamples;
-        uint8_t respOptData[MAX_OPT_DATA_LENGTH];
-        for(uint16_t i = 0; i < 3 * numSamples; i += 3) {
-          // check if the battery is good enough to continue
-          #ifdef ENABLE_INTERVAL_CONTROL
-          if(!Power_Control_Check_Battery_Limit()) {
-             // battery check failed, stop measurement and send what we have
-             respoOptDataLen = i;
-             break;
-          }
-          #endif
-
-          // read voltages
-          respOptData[i] = Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_A_VOLTAGE_PIN) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-          respOptData[i + 1] = Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_B_VOLTAGE_PIN) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-          respOptData[i + 2] = Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_C_VOLTAGE_PIN) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
-
-          // wait for for the next measurement
-          Power_Control_Delay(period * SLEEP_LENGTH_CONSTANT, true, true);
-        }
+static void Communication_Command_Set_Receive_Windows(uint8_t* optData, uint8_t) {
+  // set FSK receive length
+  Persistent_Storage_Write<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR, optData[0]);
 
-        // send response
-        Communication_Send_Response(RESP_RECORDED_SOLAR_CELLS, respOptData, respoOptDataLen);
-      }
-    } break;
+  // set LoRa receive length
+  Persistent_Storage_Write<uint8_t>(EEPROM_LORA_RECEIVE_LEN_ADDR, optData[1]);
 
-    case CMD_ROUTE:
-      // just transmit the optional data
-      Communication_Transmit(optData, optDataLen);
-      break;
+  // check if there will be still some receive window open
+  if((Persistent_Storage_Read<uint8_t>(EEPROM_LORA_RECEIVE_LEN_ADDR) == 0) && (Persistent_Storage_Read<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR) == 0)) {
+    FOSSASAT_DEBUG_PRINT(F("Res FSK"));
+    Persistent_Storage_Write<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR, FSK_RECEIVE_WINDOW_LENGTH);
   }
 }
 
+static void Communication_Command_Record_Solar_Cells(uint8_t* optData, uint8_t) {
+  uint8_t numSamples = optData[0];
+
+  // get sample period, recording is sampled by the scheduler in whole seconds
+  uint16_t period = 0;
+  memcpy(&period, optData + 1, 2);
+  period = max((period + 500) / 1000, 1);
+  FOSSASAT_DEBUG_PRINT(F("Rec"));
+  FOSSASAT_DEBUG_PRINTLN(period);
+
+  // start recording in background, samples are read by CMD_GET_SOLAR_RECORDING
+  Recording_Start(numSamples, period);
+  uint8_t respOptData[8];
+  uint8_t respOptDataLen = Recording_Get_Status(respOptData);
+  Communication_Send_Response(RESP_SOLAR_RECORDING_STATUS, respOptData, respOptDataLen);
+}
+
+static void Communication_Command_Route(uint8_t* optData, uint8_t optDataLen) {
+  // just transmit the optional data
+  Communication_Transmit(optData, optDataLen);
+}
+
+static void Communication_Command_Get_Spin_Rate(uint8_t* optData, uint8_t) {
+  uint8_t numSamples = optData[0];
+
+  // get sample period
+  uint16_t period = 0;
+  memcpy(&period, optData + 1, 2);
+  FOSSASAT_DEBUG_PRINT(F("Spin"));
+
+  // sample solar cells and estimate rotation
+  spinEstimate_t est = Spin_Estimation_Run(numSamples, period);
+
+  // send only the estimate
+  static const uint8_t respOptDataLen = sizeof(uint32_t) + 3*sizeof(uint8_t);
+  uint8_t respOptData[respOptDataLen];
+  uint8_t* respOptDataPtr = respOptData;
+  Communication_Frame_Add(&respOptDataPtr, est.period, "T");
+  Communication_Frame_Add(&respOptDataPtr, est.phase, "ph");
+  Communication_Frame_Add(&respOptDataPtr, est.confidence, "c");
+  Communication_Frame_Add(&respOptDataPtr, est.axis, "ax");
+  Communication_Send_Response(RESP_SPIN_RATE, respOptData, respOptDataLen);
+}
+
+static void Communication_Command_Start_ADC_Burst(uint8_t* optData, uint8_t) {
+  uint8_t numSamples = optData[0];
+
+  // get sample rate
+  uint16_t rate = 0;
+  memcpy(&rate, optData + 1, 2);
+  FOSSASAT_DEBUG_PRINT(F("Burst"));
+
+  // start capture in background, samples will be collected by ADC interrupt
+  if(!Pin_Interface_ADC_Burst_Start(rate, numSamples)) {
+    FOSSASAT_DEBUG_PRINTLN(F(" inv"));
+  }
+}
+
+static void Communication_Command_Get_ADC_Burst(uint8_t*, uint8_t) {
+  // stop capture so that the radio and ADC are free for other tasks
+  Pin_Interface_ADC_Burst_Stop();
+
+  // send recorded samples in the same format as CMD_RECORD_SOLAR_CELLS
+  uint8_t respOptData[3 * ADC_BURST_MAX_SAMPLES];
+  uint8_t respOptDataLen = Pin_Interface_ADC_Burst_Read(respOptData);
+  Communication_Send_Response(RESP_RECORDED_SOLAR_CELLS, respOptData, respOptDataLen);
+}
+
+static void Communication_Command_Get_Epoch_Statistics(uint8_t* optData, uint8_t) {
+  uint8_t epoch = optData[0];
+  uint8_t flags = optData[1];
+  if(epoch >= STATS_NUM_EPOCHS) {
+    FOSSASAT_DEBUG_PRINTLN(F("Ep inv"));
+    return;
+  }
+
+  // response will have maximum of TELEMETRY_STATS_LENGTH + 2 bytes if all stats are included
+  uint8_t respOptData[TELEMETRY_STATS_LENGTH + 2];
+  respOptData[0] = epoch;
+  respOptData[1] = flags;
+  uint8_t respOptDataLen = 2 + Communication_Add_Statistics(respOptData + 2, epoch, flags);
+  Communication_Send_Response(RESP_EPOCH_STATISTICS, respOptData, respOptDataLen);
+}
+
+static void Communication_Command_Reset_Epoch_Statistics(uint8_t* optData, uint8_t) {
+  if(optData[0] < STATS_NUM_EPOCHS) {
+    FOSSASAT_DEBUG_PRINT(F("Ep rst "));
+    FOSSASAT_DEBUG_PRINTLN(optData[0]);
+    Statistics_Reset(optData[0]);
+  }
+}
+
+static void Communication_Command_Set_Task_Schedule(uint8_t* optData, uint8_t) {
+  uint16_t period = 0;
+  memcpy(&period, optData + 3, 2);
+  FOSSASAT_DEBUG_PRINT(F("Task "));
+  FOSSASAT_DEBUG_PRINTLN(optData[0]);
+
+  // task will be due right away
+  if(!Scheduler_Set_Task(optData[0], optData[1], optData[2], period)) {
+    FOSSASAT_DEBUG_PRINTLN(F("inv"));
+  }
+}
+
+static void Communication_Command_Set_Listen_Modem(uint8_t* optData, uint8_t) {
+  uint8_t modem = optData[0];
+  if((modem == MODEM_LORA) || (modem == MODEM_FSK) || (modem == LISTEN_DISABLED)) {
+    FOSSASAT_DEBUG_PRINT(F("Lst "));
+    FOSSASAT_DEBUG_PRINTLN(modem);
+    Persistent_Storage_Write<uint8_t>(EEPROM_LISTEN_MODEM_ADDR, modem);
+  }
+}
+
+static void Communication_Command_Set_Sync_Word_Profile(uint8_t* optData, uint8_t) {
+  uint8_t profile = optData[0];
+  uint16_t duration = 0;
+  memcpy(&duration, optData + 1, 2);
+  if(duration > SYNC_WORD_MAX_DURATION) {
+    duration = SYNC_WORD_MAX_DURATION;
+  }
+  if((profile == SYNC_WORD_PROFILE_SHARED) || (profile == SYNC_WORD_PROFILE_MISSION)) {
+    // new profile is used from the next modem configuration, so this window stays on the current one
+    FOSSASAT_DEBUG_PRINT(F("Sync "));
+    FOSSASAT_DEBUG_PRINTLN(profile);
+    Persistent_Storage_Write<uint8_t>(EEPROM_SYNC_WORD_PROFILE_ADDR, profile);
+    Persistent_Storage_Write<uint32_t>(EEPROM_SYNC_WORD_EXPIRY_ADDR, Timekeeping_Get_Time() + (uint32_t)duration * 3600UL);
+  }
+}
+
+static void Communication_Command_Set_Battery_Capacity(uint8_t* optData, uint8_t) {
+  uint16_t capacity = 0;
+  memcpy(&capacity, optData, 2);
+  FOSSASAT_DEBUG_PRINT(F("Cap "));
+  FOSSASAT_DEBUG_PRINTLN(capacity);
+  if(!Power_Control_Set_Battery_Capacity(capacity)) {
+    FOSSASAT_DEBUG_PRINTLN(F("inv"));
+  }
+}
+
+static void Communication_Command_Queue_Command(uint8_t* optData, uint8_t optDataLen) {
+  // optional data starts with delay and function ID
+  uint32_t delay = 0;
+  memcpy(&delay, optData, 4);
+  FOSSASAT_DEBUG_PRINT(F("Qadd "));
+  FOSSASAT_DEBUG_PRINTLN(delay);
+  if(Command_Queue_Add(delay, optData[4], optData + 5, optDataLen - 5) == CMD_QUEUE_ALL) {
+    FOSSASAT_DEBUG_PRINTLN(F("full"));
+  }
+
+  // respond with queue state, so that the result can be checked
+  uint8_t respOptData[6 * CMD_QUEUE_NUM_SLOTS];
+  uint8_t respOptDataLen = Command_Queue_Get_Status(respOptData);
+  Communication_Send_Response(RESP_COMMAND_QUEUE, respOptData, respOptDataLen);
+}
+
+static void Communication_Command_Get_Command_Queue(uint8_t* optData, uint8_t optDataLen) {
+  if(optDataLen == 0) {
+    // no slot specified, send queue state
+    uint8_t respOptData[6 * CMD_QUEUE_NUM_SLOTS];
+    uint8_t respOptDataLen = Command_Queue_Get_Status(respOptData);
+    Communication_Send_Response(RESP_COMMAND_QUEUE, respOptData, respOptDataLen);
+    return;
+  }
+
+  // send stored response with its original ID
+  uint8_t respId = 0;
+  uint8_t respOptData[CMD_QUEUE_DATA_LENGTH];
+  uint8_t respOptDataLen = 0;
+  if(Command_Queue_Get_Response(optData[0], &respId, respOptData, &respOptDataLen)) {
+    Communication_Send_Response(respId, respOptData, respOptDataLen);
+  }
+}
+
+static void Communication_Command_Clear_Command_Queue(uint8_t* optData, uint8_t) {
+  FOSSASAT_DEBUG_PRINT(F("Qclr "));
+  FOSSASAT_DEBUG_PRINTLN(optData[0]);
+  Command_Queue_Clear(optData[0]);
+}
+
+static void Communication_Command_Get_Solar_Recording(uint8_t* optData, uint8_t optDataLen) {
+  if(optDataLen == 0) {
+    // no offset specified, send recording status
+    uint8_t respOptData[8];
+    uint8_t respOptDataLen = Recording_Get_Status(respOptData);
+    Communication_Send_Response(RESP_SOLAR_RECORDING_STATUS, respOptData, respOptDataLen);
+
+  } else if(optDataLen == 2) {
+    // send one page of samples in the same format as CMD_RECORD_SOLAR_CELLS used to
+    uint16_t offset = 0;
+    memcpy(&offset, optData, 2);
+    uint8_t respOptData[3 * RECORDING_PAGE_SAMPLES];
+    uint8_t respOptDataLen = Recording_Read(offset, respOptData);
+    Communication_Send_Response(RESP_RECORDED_SOLAR_CELLS, respOptData, respOptDataLen);
+  }
+}
+
+static void Communication_Command_Get_Post_Mortem(uint8_t*, uint8_t) {
+  // send record of the last reset as stored on startup, followed by radio recovery counters
+  uint8_t respOptData[sizeof(postMortemRecord_t) + RADIO_RECOVERY_NUM_TIERS*sizeof(uint16_t)];
+  Persistent_Storage_Read_Bytes(EEPROM_POST_MORTEM_ADDR, respOptData, sizeof(respOptData));
+  Communication_Send_Response(RESP_POST_MORTEM, respOptData, sizeof(respOptData));
+}
+
+// all commands as given by the command table
+#define COMMAND_ENTRY(id, minLen, maxLen, flags, energy, func) { id, minLen, maxLen, flags, energy, func },
+static const commandDef_t commandTable[] PROGMEM = {
+  COMMAND_TABLE(COMMAND_ENTRY)
+};
+#undef COMMAND_ENTRY
+
+bool Communication_Get_Command(uint8_t functionId, commandDef_t* cmd) {
+  for(uint8_t i = 0; i < sizeof(commandTable) / sizeof(commandDef_t); i++) {
+    if(pgm_read_byte(&commandTable[i].id) == functionId) {
+      memcpy_P(cmd, &commandTable[i], sizeof(commandDef_t));
+      return(true);
+    }
+  }
+  return(false);
+}
+
+uint8_t Communication_Check_Command(const commandDef_t& cmd, uint8_t optDataLen) {
+  if((optDataLen < cmd.minLen) || (optDataLen > cmd.maxLen)) {
+    return(NACK_LENGTH);
+  }
+
+  // low power mode only allows commands marked for it
+  #ifdef ENABLE_INTERVAL_CONTROL
+  if(powerConfig.bits.lowPowerModeActive && !(cmd.flags & CMD_FLAG_LOW_POWER)) {
+    return(CMD_REFUSED);
+  }
+  #endif
+
+  // check the battery can cover the command (comparison fails when charge is not known yet)
+  if((cmd.energy > 0) && (Power_Control_Get_Charge_Margin(TX_RESERVE_SOC) * 3600.0 < cmd.energy)) {
+    return(CMD_REFUSED);
+  }
+
+  return(0x00);
+}
+
+void Communication_Execute_Function(const commandDef_t& cmd, uint8_t* optData, uint8_t optDataLen) {
+  /*FOSSASAT_DEBUG_PRINT("Communication_Execute_Function ");
+  FOSSASAT_DEBUG_PRINTLN(freeRam());
+  FOSSASAT_DEBUG_DELAY(100);*/
+
+  // validate against the command table
+  uint8_t result = Communication_Check_Command(cmd, optDataLen);
+  if(result != 0x00) {
+    FOSSASAT_DEBUG_PRINT(F("CmdErr"));
+    FOSSASAT_DEBUG_PRINTLN(result);
+    if(result != CMD_REFUSED) {
+      Communication_Nack(result);
+      return;
+    }
+
+    // refused command is still a valid frame, acknowledge it with the reason
+    Persistent_Storage_Increment_Frame_Counter(true);
+    commandRefusals++;
+    Communication_Acknowledge(cmd.id, CMD_REFUSED);
+    return;
+  }
+
+  // increment valid frame counter
+  Persistent_Storage_Increment_Frame_Counter(true);
+
+  // acknowledge frame
+  Communication_Acknowledge(cmd.id, 0x00);
+
+  // execute function
+  Post_Mortem_Set_Function(cmd.id);
+  cmd.func(optData, optDataLen);
+  Post_Mortem_Set_Function(POST_MORTEM_NONE);
+}
+
 int16_t Communication_Send_Response(uint8_t respId, uint8_t* optData, size_t optDataLen, bool overrideModem) {
   /*FOSSASAT_DEBUG_PRINT("Communication_Send_Response ");
   FOSSASAT_DEBUG_PRINTLN(freeRam());
   FOSSASAT_DEBUG_DELAY(100);*/
 
-  // get callsign from EEPROM
-  uint8_t callsignLen = Persistent_Storage_Read<uint8_t>(EEPROM_CALLSIGN_LEN_ADDR);
-  char callsign[MAX_STRING_LENGTH + 1];
-  System_Info_Get_Callsign(callsign, callsignLen);
+  // responses of queued commands are stored for the next pass
+  if(Command_Queue_Capture_Response(respId, optData, optDataLen)) {
+    return(ERR_NONE);
+  }
 
   // build response frame
+  // FOSSA-Comms takes non-const callsign, but only reads it
+  char* callsign = (char*)System_Info_Get_Callsign();
   uint8_t len = FCP_Get_Frame_Length(callsign, optDataLen);
   uint8_t frame[MAX_RADIO_BUFFER_LENGTH];
   FCP_Encode(frame, callsign, respId, optDataLen, optData);
@@ -716,6 +921,43 @@ int16_t Communication_Send_Response(uint8_t respId, uint8_t* optData, size_t opt
   return(state);
 }
 
+static int16_t Communication_Transmit_Frame(uint8_t* data, uint8_t len) {
+  // get timeout
+  uint32_t timeout = 0;
+  if(currentModem == MODEM_FSK) {
+    timeout = (float)radio.getTimeOnAir(len) * 5.0;
+  } else {
+    timeout = (float)radio.getTimeOnAir(len) * 1.5;
+  }
+  FOSSASAT_DEBUG_PRINT(F("T/O="));
+  FOSSASAT_DEBUG_PRINTLN(timeout);
+
+  // start transmitting
+  int16_t state = radio.startTransmit(data, len);
+  if(state != ERR_NONE) {
+    FOSSASAT_DEBUG_PRINT(F("TxErr"));
+    FOSSASAT_DEBUG_PRINTLN(state);
+    Post_Mortem_Set_Radio_Error(state);
+    return(state);
+  }
+
+  // wait for transmission finish
+  uint32_t start = micros();
+  while(!digitalRead(RADIO_DIO1)) {
+    // check timeout
+    if(micros() - start > timeout) {
+      // timed out while transmitting
+      Post_Mortem_Set_Radio_Error(ERR_TX_TIMEOUT);
+      radio.standby();
+      FOSSASAT_DEBUG_PRINTLN(F("Tx t/o"));
+      return(ERR_TX_TIMEOUT);
+    }
+  }
+
+  // transmission done, set mode standby
+  return(radio.standby());
+}
+
 int16_t Communication_Transmit(uint8_t* data, uint8_t len, bool overrideModem) {
   /*FOSSASAT_DEBUG_PRINT("Communication_Transmit ");
   FOSSASAT_DEBUG_PRINTLN(freeRam());
@@ -750,74 +992,148 @@ int16_t Communication_Transmit(uint8_t* data, uint8_t len, bool overrideModem) {
     FOSSASAT_DEBUG_PRINTLN();
   }
 
-  // get timeout
-  uint32_t timeout = 0;
-  if(currentModem == MODEM_FSK) {
-    timeout = (float)radio.getTimeOnAir(len) * 5.0;
+  // check there is enough energy left for the whole frame
+  int16_t state = TX_ERR_REFUSED;
+  if(Communication_Admit_Transmission(len) == TX_ADMIT_REFUSED) {
+    FOSSASAT_DEBUG_PRINTLN(F("Tx 0 bat"));
   } else {
-    timeout = (float)radio.getTimeOnAir(len) * 1.5;
+    state = Communication_Transmit_Frame(data, len);
   }
-  FOSSASAT_DEBUG_PRINT(F("T/O="));
-  FOSSASAT_DEBUG_PRINTLN(timeout);
 
-  // start transmitting
-  int16_t state = radio.startTransmit(data, len);
-  if(state != ERR_NONE) {
-    FOSSASAT_DEBUG_PRINT(F("TxErr"));
-    FOSSASAT_DEBUG_PRINTLN(state);
-    return(state);
+  // restore modem or output power, whatever the result was, radio that timed out is configured again
+  if(overrideModem || (state == ERR_TX_TIMEOUT)) {
+    Communication_Set_Modem(modem);
+  } else if(txAdmission == TX_ADMIT_REDUCED) {
+    radio.setOutputPower(currentModem == MODEM_LORA ? LORA_OUTPUT_POWER : FSK_OUTPUT_POWER);
   }
 
-  // wait for transmission finish
-  uint32_t start = micros();
-  uint32_t lastBeat = 0;
-  while(!digitalRead(RADIO_DIO1)) {
-    // pet watchdog every second
-    if(micros() - lastBeat > (uint32_t)WATCHDOG_LOOP_HEARTBEAT_PERIOD * (uint32_t)1000) {
-      Pin_Interface_Watchdog_Heartbeat();
-
-      // check whether voltage dropped below low power level
-      #ifdef ENABLE_INTERVAL_CONTROL
-      if(powerConfig.bits.lowPowerModeActive) {
-        // we're below low power level, stop the transmission
-        FOSSASAT_DEBUG_PRINTLN(F("Tx 0 bat"));
-        radio.standby();
-        return(ERR_INVALID_DATA_RATE);
-      }
-      #endif
+  // set receive ISR
+  radio.setDio1Action(Communication_Receive_Interrupt);
+
+  return(state);
+}
+
+// start of the current pass (s), its charge budget and the charge admitted so far (mAh)
+uint32_t txBudgetStart = 0;
+float txBudget = NAN;
+float txBudgetSpent = 0;
+
+uint8_t Communication_Admit_Transmission(uint8_t len) {
+  txAdmission = TX_ADMIT_FULL;
+
+  #ifdef ENABLE_INTERVAL_CONTROL
+  // get output power and current limit of the active modem
+  int8_t power = FSK_OUTPUT_POWER;
+  float currentLimit = FSK_CURRENT_LIMIT;
+  if(currentModem == MODEM_LORA) {
+    power = LORA_OUTPUT_POWER;
+    currentLimit = LORA_CURRENT_LIMIT;
+  }
 
-      lastBeat = micros();
+  // predict charge needed for the frame (mAh)
+  float timeOnAir = (float)radio.getTimeOnAir(len) / 3600000000.0;
+  float fullCharge = min((float)(TX_CURRENT_OFFSET + TX_CURRENT_SLOPE * power), currentLimit) * timeOnAir;
+  float reducedCharge = min((float)(TX_CURRENT_OFFSET + TX_CURRENT_SLOPE * TX_REDUCED_OUTPUT_POWER), currentLimit) * timeOnAir;
+
+  // new pass gets a share of the charge margin at its start
+  uint32_t now = Timekeeping_Get_Uptime();
+  if(isnan(txBudget) || (now - txBudgetStart >= TX_BUDGET_PERIOD)) {
+    txBudgetStart = now;
+    txBudget = max(Power_Control_Get_Charge_Margin(TX_RESERVE_SOC), (float)0) * TX_BUDGET_SHARE;
+    txBudgetSpent = 0;
+  }
+
+  if(isnan(txBudget)) {
+    // charge not known yet, fall back to power mode
+    if(powerConfig.bits.criticalModeActive) {
+      txAdmission = TX_ADMIT_REDUCED;
     }
+  } else if(txBudgetSpent + reducedCharge > txBudget) {
+    txAdmission = TX_ADMIT_REFUSED;
+  } else if(txBudgetSpent + fullCharge > txBudget) {
+    txAdmission = TX_ADMIT_REDUCED;
+  }
 
-    // check timeout
-    if(micros() - start > timeout) {
-      // timed out while transmitting
-      radio.standby();
-      Communication_Set_Modem(modem);
-      FOSSASAT_DEBUG_PRINTLN(F("Tx t/o"));
-      return(ERR_TX_TIMEOUT);
+  // count the admitted charge against the budget of this pass
+  if(txAdmission == TX_ADMIT_FULL) {
+    txBudgetSpent += fullCharge;
+  } else if(txAdmission == TX_ADMIT_REDUCED) {
+    txBudgetSpent += reducedCharge;
+  }
+
+  FOSSASAT_DEBUG_PRINT(F("Adm "));
+  FOSSASAT_DEBUG_PRINTLN(txAdmission);
+  if(txAdmission == TX_ADMIT_REDUCED) {
+    radio.setOutputPower(TX_REDUCED_OUTPUT_POWER);
+  }
+  #else
+  (void)len;
+  #endif
+
+  txAdmissionCounters[txAdmission]++;
+  return(txAdmission);
+}
+
+uint32_t Communication_Get_Listen_Length(uint32_t interval) {
+  // no listening in critical power mode
+  if(powerConfig.bits.criticalModeActive) {
+    return(0);
+  }
+
+  float margin = Power_Control_Get_Charge_Margin(LISTEN_RESERVE_SOC);
+  if(isnan(margin)) {
+    // charge not known yet, fall back to power mode
+    if(powerConfig.bits.lowPowerModeActive) {
+      return(interval / 2);
     }
+    return(interval);
+  } else if(margin <= 0) {
+    return(0);
   }
 
-  // transmission done, set mode standby
-  state = radio.standby();
+  // spend only a small part of the margin in one sleep
+  float budget = (margin * 3600.0 * LISTEN_ENERGY_SHARE) / LISTEN_AVERAGE_CURRENT;
+  if(budget < interval) {
+    return(budget);
+  }
+  return(interval);
+}
 
-  // restore modem
-  if(overrideModem) {
-    Communication_Set_Modem(modem);
+uint8_t Communication_Get_Listen_Modem() {
+  uint8_t modem = Persistent_Storage_Read<uint8_t>(EEPROM_LISTEN_MODEM_ADDR);
+  if((modem != MODEM_LORA) && (modem != MODEM_FSK) && (modem != LISTEN_DISABLED)) {
+    // not set yet
+    modem = LISTEN_MODEM_DEFAULT;
   }
+  return(modem);
+}
 
-  // set receive ISR
+bool Communication_Listen(uint32_t len) {
+  uint8_t modem = Communication_Get_Listen_Modem();
+  uint16_t preambleLen = LISTEN_FSK_PREAMBLE_LENGTH;
+  if(modem == MODEM_LORA) {
+    preambleLen = LISTEN_LORA_PREAMBLE_LENGTH;
+  }
+
+  // radio sleeps between short receive periods, timed by the radio itself
+  Communication_Set_Modem(modem);
   radio.setDio1Action(Communication_Receive_Interrupt);
+  radio.startReceiveDutyCycleAuto(preambleLen);
 
-  return(state);
-}
+  bool received = false;
+  uint32_t start = Timekeeping_Get_Uptime();
+  while(!received && (Timekeeping_Get_Uptime() - start < len)) {
+    Power_Control_Delay(500, true);
 
-bool Communication_Check_OptDataLen(uint8_t expected, uint8_t actual) {
-  if(expected != actual) {
-    // received length of optional data does not match expected
-    return(false);
+    // edge interrupt can't wake the MCU from power down, check DIO1 level as well
+    if(dataReceived || digitalRead(RADIO_DIO1)) {
+      radio.standby();
+      Communication_Process_Packet();
+      received = true;
+    }
   }
 
-  return(true);
+  radio.clearDio1Action();
+  radio.standby();
+  return(received);
 }
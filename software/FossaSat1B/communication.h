@@ -93,6 +93,13 @@ void Communication_CW_Beep(uint32_t len);
  */
 void Communication_Send_System_Info();
 
+/**
+ * @brief Expands the AES key schedule of encryptionKey, which is then used to decrypt all private frames.
+ * Must be called once during setup.
+ *
+ */
+void Communication_Init_Encryption();
+
 /**
  * @brief This function sends acknowledge for a received frame.
  *
@@ -103,6 +110,16 @@ void Communication_Send_System_Info();
  */
 void Communication_Acknowledge(uint8_t functionId, uint8_t result);
 
+/**
+ * @brief Counts an invalid frame and answers it by NACK, unless it was for another station or the token bucket
+ * of its error class is empty, see @ref defines_nack.
+ *
+ * @test (ID COMMS_H_T19) (SEV 1) Check that a burst of invalid frames is answered by at most NACK_BUCKET_SIZE NACKs.
+ *
+ * @param result Error class, see @ref defines_nack.
+ */
+void Communication_Nack(uint8_t result);
+
 /**
  * @brief This function reads the contents of the radio when it receives a transmission.
  *
@@ -111,6 +128,46 @@ void Communication_Acknowledge(uint8_t functionId, uint8_t result);
  */
 void Communication_Process_Packet();
 
+/**
+ * @brief Command handler, called with optional data that was already validated against the command table.
+ */
+typedef void (*commandFunc_t)(uint8_t* optData, uint8_t optDataLen);
+
+/**
+ * @brief Entry of the command table, stored in flash. All commands are defined by this table only.
+ */
+struct commandDef_t {
+  uint8_t id;
+  uint8_t minLen;
+  uint8_t maxLen;
+  uint8_t flags;
+  uint16_t energy;
+  commandFunc_t func;
+};
+
+/**
+ * @brief View of a received frame. Optional data points into the buffer the frame was received to, nothing is copied.
+ * Command definition is looked up once when the frame is parsed and used for execution.
+ */
+struct frameView_t {
+  commandDef_t cmd;
+  uint8_t optDataLen;
+  uint8_t* optData;
+};
+
+/**
+ * @brief Validates callsign, function ID and optional data length of a frame in a single pass, without copying it.
+ * Optional data of private frames is left encrypted, it is decrypted in place by Comunication_Parse_Frame.
+ *
+ * @test (ID COMMS_H_T18) (SEV 1) Check that frames with wrong callsign, unknown function ID or wrong optional data length are rejected.
+ *
+ * @param frame The raw data to parse.
+ * @param len The length of the raw data.
+ * @param view View to fill, optional data pointer will point into frame.
+ * @return uint8_t 0x00 when the frame is valid, NACK error class otherwise (see @ref defines_nack).
+ */
+uint8_t Communication_Parse_View(uint8_t* frame, size_t len, frameView_t* view);
+
 /**
  * @brief This function parses the internal contents of the message using the FOSSA COMMS Protocol
  *
@@ -122,16 +179,42 @@ void Communication_Process_Packet();
 void Comunication_Parse_Frame(uint8_t* frame, size_t len);
 
 /**
- * @brief This function executes the given function id provided with the given data.
+ * @brief Finds command in the command table. Received frames are looked up once by Communication_Parse_View,
+ * this is only used for commands that are not received in a frame (command queue).
+ *
+ * @test (ID COMMS_H_T20) (SEV 1) Check that every function ID defined in configuration.h has exactly one entry and that all private IDs are encrypted.
+ *
+ * @param functionId Function ID to look for.
+ * @param cmd Command definition to fill.
+ * @return true Command was found.
+ * @return false Unknown function ID.
+ */
+bool Communication_Get_Command(uint8_t functionId, commandDef_t* cmd);
+
+/**
+ * @brief Checks optional data length, low power mode and battery charge against the command table.
+ *
+ * @test (ID COMMS_H_T21) (SEV 1) Check that commands without CMD_FLAG_LOW_POWER are refused while low power mode is active.
+ * @test (ID COMMS_H_T22) (SEV 2) Check that refused commands are counted as valid frames and reported as refusals in packet info.
+ *
+ * @param cmd Command definition.
+ * @param optDataLen Length of the optional data.
+ * @return uint8_t 0x00 when the command can be executed, CMD_REFUSED when it is valid but can't be executed now,
+ * NACK error class otherwise (see @ref defines_nack).
+ */
+uint8_t Communication_Check_Command(const commandDef_t& cmd, uint8_t optDataLen);
+
+/**
+ * @brief This function executes the given command provided with the given data.
  *
  * @test (ID COMMS_H_T11) (SEV 1) Test that each command is responded to with the correct function and data.
  *
- * @param functionId The function to execute.
+ * @param cmd Command definition from the command table.
  * @param optData  The data to give to the function.
  * @param optDataLen The length of the data that is given to the function.
  *
  */
-void Communication_Execute_Function(uint8_t functionId, uint8_t* optData = NULL, size_t optDataLen = 0);
+void Communication_Execute_Function(const commandDef_t& cmd, uint8_t* optData = NULL, uint8_t optDataLen = 0);
 
 /**
  * @brief Responds to a given function id execution (internally used).
@@ -155,20 +238,47 @@ int16_t Communication_Send_Response(uint8_t respId, uint8_t* optData = nullptr,
  * @param data The byte array to transmit.
  * @param len The length of the byte array to transmit.
  * @param overrideModem Override the modem to use default LoRa modem and settings.
- * @return int16_t The status code of the Radio.Tranmit() function.
+ * @return int16_t The status code of the Radio.Tranmit() function, TX_ERR_REFUSED when the frame was not admitted.
  */
 int16_t Communication_Transmit(uint8_t* data, uint8_t len, bool overrideModem = true);
 
 /**
- * @brief Helper functions to check two variables are equal, with debug prints.
+ * @brief Decides whether a frame can be transmitted given the predicted charge it will consume and the charge budget
+ * of the current pass, see @ref defines_transmit_admission. The decision is saved in txAdmission and counted in txAdmissionCounters.
+ *
+ * @test (ID COMMS_H_T15) (SEV 1) Check that the decision changes from full to reduced to refused as battery charge decreases.
+ *
+ * @param len The length of the frame to transmit.
+ * @return uint8_t Admission decision, see @ref defines_transmit_admission
+ */
+uint8_t Communication_Admit_Transmission(uint8_t len);
+
+/**
+ * @brief Gets the number of seconds that can be spent listening during a sleep, given the battery charge margin.
+ *
+ * @test (ID COMMS_H_T16) (SEV 1) Check that the listening time decreases with battery charge and is 0 in critical power mode.
+ *
+ * @param interval Length of the sleep (s).
+ * @return uint32_t Listening time (s), at most interval.
+ */
+uint32_t Communication_Get_Listen_Length(uint32_t interval);
+
+/**
+ * @brief Gets the modem used for listening during sleep.
+ *
+ * @return uint8_t MODEM_LORA, MODEM_FSK or LISTEN_DISABLED.
+ */
+uint8_t Communication_Get_Listen_Modem();
+
+/**
+ * @brief Listens in duty-cycled receive mode, with the MCU in power down between radio interrupts.
+ * Stops early when a frame was received, so that the caller can reconsider its schedule.
  *
- * @test (ID COMMS_H_T14) (SEV 1) Check that this function equates correctly.
+ * @test (ID COMMS_H_T17) (SEV 1) Check that average current while listening is close to LISTEN_AVERAGE_CURRENT.
  *
- * @param expected The expected value
- * @param actual The given value.
- * @return true They are the same value.
- * @return false They are not the same value.
+ * @param len Listening time (s).
+ * @return bool Whether a frame was received.
  */
-bool Communication_Check_OptDataLen(uint8_t expected, uint8_t actual);
+bool Communication_Listen(uint32_t len);
 
 #endif
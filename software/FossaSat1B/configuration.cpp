@@ -12,8 +12,15 @@ uint8_t currentModem;
 // current spreading factor mode
 uint8_t spreadingFactorMode;
 
-// timestamps
-uint32_t lastHeartbeat = 0;
+// transmission admission
+uint8_t txAdmission = TX_ADMIT_FULL;
+uint16_t txAdmissionCounters[TX_ADMIT_REFUSED + 1] = { 0, 0, 0 };
+
+// invalid frames of each NACK error class
+uint16_t nackCounters[NACK_NUM_CLASSES] = { 0, 0, 0, 0, 0, 0 };
+
+// valid commands refused due to low power mode or battery charge
+uint16_t commandRefusals = 0;
 
 // INA226 instance
 INA226 ina;
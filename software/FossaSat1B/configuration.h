@@ -26,8 +26,6 @@
  * @defgroup defines_string_memory_limits String Limits
  * @{
  */
-#define MAX_STRING_LENGTH                               32			/*!< String length limit (bytes). */
-#define MAX_OPT_DATA_LENGTH                             128			/*!< Optional data length limit (bytes). */
 #define MAX_RADIO_BUFFER_LENGTH                         (MAX_STRING_LENGTH + 2 + MAX_OPT_DATA_LENGTH)     /*!< Radio buffer length limit. */
 
 /**
@@ -52,15 +50,22 @@
  * @}
  */
 
+// command table and telemetry schema are shared with the ground station, telemetry depends on ENABLE_INA226
+#include "commands.h"
+#include "crypto.h"
+#include "telemetry.h"
 
 /**
  * @defgroup defines_power_management_configuration Power Management Configuration
  *
  * @test (ID CONF_POWER_MANAGEMENT_T0) (SEV 1) Check that the satellite switches to low power mode when its voltage goes below BATTERY_VOLTAGE_LIMIT.
+ * @test (ID CONF_POWER_MANAGEMENT_T8) (SEV 1) Check that the satellite only returns from low power mode once its voltage goes above BATTERY_VOLTAGE_LIMIT_EXIT.
+ * @test (ID CONF_POWER_MANAGEMENT_T9) (SEV 1) Check that power mode only changes after battery checks requested it for POWER_MODE_DWELL_TIME.
  * @test (ID CONF_POWER_MANAGEMENT_T1) (SEV 2) Check that the satellite sends a morse beacon transmission when it switches to Low Power Mode.
  * @test (ID CONF_POWER_MANAGEMENT_T2) (SEV 1) Check that the battery stops charging when the temperature goes below this threshold, and starts charging again when it is not.
  * @test (ID CONF_POWER_MANAGEMENT_T3) (SEV 1) Check that the watchdog is signalled every WATCHDOG_LOOP_HEARTBEAT_PERIOD.
- * @test (ID CONF_POWER_MANAGEMENT_T4) (SEV 1) Check that the satellite sleeping times using the SLEEP_LENGTH_CONSTANT is suitable to account for the LowPower libraries overhead.
+ * @test (ID CONF_POWER_MANAGEMENT_T10) (SEV 1) Check that the satellite restarts when the main loop hangs for WATCHDOG_LIVENESS_DEADLINE.
+ * @test (ID CONF_POWER_MANAGEMENT_T4) (SEV 1) Check that the satellite sleeping times using the calibrated tick length are suitable to account for the LowPower libraries overhead.
  * @test (ID CONF_POWER_MANAGEMENT_T5) (SEV 1) Check that the satellite does not deploy after DEPLOYMENT_ATTEMPS has reached.
  * @test (ID CONF_POWER_MANAGEMENT_T6) (SEV 1) Check that the satellite waits for this amount of time before the deploy sequence starts, this is for jettison.
  * @test (ID CONF_POWER_MANAGEMENT_T7) (SEV 5) Check that each debug print waits DEPLOYMENT_DEBUG_SAMPLE_PERIOD amount of time between each print.
@@ -70,16 +75,50 @@
  * @{
  */
 #define BATTERY_VOLTAGE_LIMIT                           3.8f        /*!< Battery voltage limit to enable low power mode (V). */
+#define BATTERY_VOLTAGE_LIMIT_EXIT                      3.9f        /*!< Battery voltage limit to leave low power mode (V). */
+#define BATTERY_CRITICAL_VOLTAGE_LIMIT                  3.6f        /*!< Battery voltage limit to enable critical power mode (V). */
+#define BATTERY_CRITICAL_VOLTAGE_LIMIT_EXIT             3.7f        /*!< Battery voltage limit to leave critical power mode (V). */
+#define POWER_MODE_DWELL_TIME                           90          /*!< Time for which all battery checks have to request the same power mode before it is changed (s). */
 #define BATTERY_CW_BEEP_VOLTAGE_LIMIT                   3.8f        /*!< Battery voltage limit to switch into morse beep (V). */
 #define BATTERY_TEMPERATURE_LIMIT                       -0.7f       /*!< Battery charging temperature limit (deg. C). */
-#define WATCHDOG_LOOP_HEARTBEAT_PERIOD                  1000        /*!< Watchdog heartbeat period in loop() (ms). */
-#define WATCHDOG_RESET_NUM_SLEEP_CYCLES                 4           /*!< Number of 8-second sleep cycles to reset watchdog */
-#define SLEEP_LENGTH_CONSTANT                           0.9         /*!< Sleep times are multiplied by this constant to compensate for the LowPower libraries overhead. */
+#define WATCHDOG_LOOP_HEARTBEAT_PERIOD                  500         /*!< Watchdog heartbeat period, signalled from Timer2 interrupt while awake and after each power down period (ms). */
+#define WATCHDOG_TIMER_TICK                             10          /*!< Timer2 compare match period (ms). */
+#define WATCHDOG_LIVENESS_DEADLINE                      300         /*!< Heartbeat stops when the main loop didn't check in for this long, must be longer than any task (s). */
 #define DEPLOYMENT_ATTEMPTS                             4           /*!< Number of deployment attempts. */
 #define DEPLOYMENT_SLEEP_LENGTH                         1800000     /*!< Sleep for this period of time before deployment (ms) */
 #define DEPLOYMENT_DEBUG_LENGTH                         60          /*!< How long to wait until the debugging print routine breaks (s). See: FossaSat1B.ino */
 #define DEPLOYMENT_DEBUG_SAMPLE_PERIOD                  1000        /*!< How long to wait between each debug parameter print (ms). See: FossaSat1B.ino */
-#define AUTODEPLOY_DELAY                                1200        /*!< How long to wait bevore attempting automated deployment in main loop (seconds). See: FossaSat1B.ino */
+#define AUTODEPLOY_DELAY                                1200        /*!< How long to wait bevore attempting automated deployment after setup (seconds). See: scheduler.cpp */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_state_of_charge State of Charge Estimation
+ *
+ * @brief INA226 only measures the charging current, so the coulomb counter integrates it minus the average load
+ * of the current power mode. Battery voltage is only used as rest voltage after no charging current was seen for
+ * SOC_REST_INTERVAL. Battery capacity is kept in EEPROM, so that it can be set by CMD_SET_BATTERY_CAPACITY once the flight
+ * battery was characterized, BATTERY_CAPACITY is used until then.
+ *
+ * @test (ID CONF_SOC_T0) (SEV 2) Check that the state of charge follows the integrated INA226 current between rest voltage readings.
+ * @test (ID CONF_SOC_T1) (SEV 2) Check that the state of charge is only saved to EEPROM after it changed by at least SOC_SAVE_THRESHOLD.
+ * @test (ID CONF_SOC_T2) (SEV 2) Check that the state of charge decreases in eclipse by the load current of the power mode.
+ *
+ * @{
+ */
+#define BATTERY_CAPACITY                                2600        /*!< Default battery capacity, used until set by CMD_SET_BATTERY_CAPACITY (mAh). */
+#define BATTERY_CAPACITY_MIN                            500         /*!< Minimum battery capacity accepted from EEPROM or command (mAh). */
+#define BATTERY_CAPACITY_MAX                            10000       /*!< Maximum battery capacity accepted from EEPROM or command (mAh). */
+#define SOC_LOAD_CURRENT_NORMAL                         25.0        /*!< Average load current in normal power mode, including beacons and receive windows (mA). */
+#define SOC_LOAD_CURRENT_LOW                            12.0        /*!< Average load current in low power mode (mA). */
+#define SOC_LOAD_CURRENT_CRITICAL                       6.0         /*!< Average load current in critical power mode (mA). */
+#define SOC_REST_CURRENT_LIMIT                          5.0         /*!< Charging current below this limit is treated as no charging (mA). */
+#define SOC_REST_INTERVAL                               600         /*!< Time without charging current before battery voltage is treated as rest voltage (s). */
+#define SOC_REST_UNKNOWN                                0xFFFFFFFF  /*!< Start of rest interval while charging, or before the first current sample. */
+#define SOC_ANCHOR_WEIGHT                               0.05        /*!< Weight of the rest voltage estimate when re-anchoring the coulomb counter (0 - 1). */
+#define SOC_SAVE_THRESHOLD                              2           /*!< Minimum change of state of charge before it is saved to EEPROM (%). */
+#define SOC_UNKNOWN                                     0xFF        /*!< State of charge value reported before the first rest voltage reading. */
 /**
  * @}
  */
@@ -100,6 +139,7 @@
 #define MPPT_TEMP_SWITCH_ENABLED                        1           /*!< Whether the temperature affects the MPPT circuits (0 is no, 1 is yes). */
 #define MPPT_KEEP_ALIVE_ENABLED                         0           /*!< Whether the MPPT circuit disabling feature is enabled (0 is no, 1 is yes).*/
 #define TRANSMIT_ENABLED                                1           /*!< Whether the satellite can transmit (0 is no, 1 is yes). */
+#define CRITICAL_MODE_ACTIVE                            0           /*!< Whether the critical power mode is currently active (0 is no, 1 is yes). */
 /**
  * @}
  */
@@ -120,40 +160,123 @@
  * @}
  */
 
+/**
+ * @defgroup defines_statistics Statistics
+ *
+ * @brief Epochs of the statistics engine, channels are defined by the telemetry schema (see @ref defines_telemetry).
+ * Samples are accumulated in RAM for the current orbit, which is merged into daily and lifetime accumulators
+ * in EEPROM when it ends.
+ *
+ * @test (ID CONF_STATS_T0) (SEV 2) Check that mean and standard deviation match values calculated from system info frames.
+ * @test (ID CONF_STATS_T1) (SEV 2) Check that the daily epoch is rolled over after STATS_DAY_PERIOD, including restarts.
+ *
+ * @{
+ */
+#define STATS_EPOCH_ORBIT                               0           /*!< Current orbit, kept in RAM only. */
+#define STATS_EPOCH_DAY                                 1           /*!< Current day. */
+#define STATS_EPOCH_LIFETIME                            2           /*!< Since the last reset of this epoch. */
+#define STATS_NUM_EPOCHS                                3           /*!< Total number of epochs. */
+#define STATS_ORBIT_PERIOD                              5700        /*!< Orbit epoch length (seconds). */
+#define STATS_DAY_PERIOD                                86400       /*!< Daily epoch length (seconds). */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_command_queue Command Queue
+ *
+ * @brief Time-tagged commands stored in EEPROM, executed when total time reaches their target. Responses of executed commands
+ * are kept in the same slot until it is reused, so that they can be downlinked during the next pass.
+ *
+ * @test (ID CONF_CMD_QUEUE_T0) (SEV 1) Check that a queued command is executed at its target time, including restarts.
+ * @test (ID CONF_CMD_QUEUE_T1) (SEV 2) Check that a command with longer response is stored truncated.
+ *
+ * @{
+ */
+#define CMD_QUEUE_NUM_SLOTS                             4           /*!< Number of queue slots. */
+#define CMD_QUEUE_EMPTY                                 0xFF        /*!< Slot state: free, same as erased EEPROM. */
+#define CMD_QUEUE_PENDING                               0x01        /*!< Slot state: command waits for its target time. */
+#define CMD_QUEUE_DONE                                  0x02        /*!< Slot state: command was executed, response is stored. */
+#define CMD_QUEUE_ALL                                   0xFF        /*!< Slot index selecting all slots. */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_post_mortem Post-Mortem Record
+ *
+ * @brief Context of the program is kept in RAM that is not cleared on reset. On startup, it is saved to EEPROM
+ * together with MCUSR reset flags, so that the cause of the last reset can be downlinked.
+ *
+ * @test (ID CONF_POST_MORTEM_T0) (SEV 1) Check that CMD_RESTART is reported with POST_MORTEM_REASON_COMMAND and watchdog reset flag.
+ * @test (ID CONF_POST_MORTEM_T1) (SEV 2) Check that a hang in a task is reported with external reset flag and the task identifier.
+ *
+ * @{
+ */
+#define POST_MORTEM_MAGIC                               0xA5C3      /*!< Marks valid context in RAM, anything else is left from power-on. */
+#define POST_MORTEM_NONE                                0xFF        /*!< No function ID or unknown phase. */
+#define POST_MORTEM_PHASE_SETUP                         0xF0        /*!< Phase: setup(). */
+#define POST_MORTEM_PHASE_IDLE                          0xF1        /*!< Phase: scheduler between tasks, other phases are scheduler task identifiers. */
+#define POST_MORTEM_REASON_NONE                         0x00        /*!< Reset was not requested by the firmware. */
+#define POST_MORTEM_REASON_COMMAND                      0x01        /*!< Reset requested by CMD_RESTART. */
+#define POST_MORTEM_REASON_RADIO                        0x02        /*!< Reset after radio initialization failed. */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_radio_recovery Radio Recovery
+ *
+ * @brief When radio initialization fails, recovery continues with the next tier until it succeeds. Tier t waits
+ * RADIO_RECOVERY_BACKOFF * 2^t before initializing again, only the last tier restarts the satellite.
+ *
+ * @test (ID CONF_RADIO_RECOVERY_T0) (SEV 1) Check that the radio recovers without restart when SPI is disturbed during initialization.
+ *
+ * @{
+ */
+#define RADIO_RECOVERY_RETRY                            0           /*!< Initialize again. */
+#define RADIO_RECOVERY_RECONFIGURE                      1           /*!< Standby, then initialize again. */
+#define RADIO_RECOVERY_REINIT                           2           /*!< Cold sleep to clear all radio registers, wake up, then initialize again. */
+#define RADIO_RECOVERY_REBOOT                           3           /*!< Restart the satellite. */
+#define RADIO_RECOVERY_NUM_TIERS                        4           /*!< Total number of tiers. */
+#define RADIO_RECOVERY_BACKOFF                          10          /*!< Base delay before initializing again (ms). */
+/**
+ * @}
+ */
+
 /**
  * @defgroup defines_eeprom_address_map EEPROM Address Map
  *
- * @brief
+ * @brief All addresses are derived from eepromLayout_t, the table is checked at compile time.
  * |Description|Start Address|End Address|Length (bytes)|
  * |--|--|--|--|
  * |Deployment counter (uint8_t).|0x0000|0x0000|1|
- * |Power configuration (powerConfig_t).|0x0001|0x0001|1|
+ * |Layout version (uint8_t).|0x0001|0x0001|1|
  * |First run (uint8_t).|0x0002|0x0002|1|
  * |Restart counter (uint16_t).|0x0003|0x0004|2|
  * |FSK receive window length (uint8_t).|0x0005|0x0005|1|
  * |LoRa receive window length (uint8_t).|0x0006|0x0006|1|
- * |Seconds elapsed since last reset (uint32_t).|0x0007|0x000A|4|
- * |Number of main loop iterations (uint8_t).|0x000B|0x000B|1|
- * |Number of received valid LoRa frames (uint16_t).|0x000C|0x000D|2|
- * |Number of received invalid LoRa frames (uint16_t).|0x000E|0x000F|2|
- * |Number of received valid FSK frames (uint16_t).|0x0010|0x0011|2|
- * |Number of received invalid FSK frames (uint16_t).|0x0012|0x0013|2|
+ * |Unused (uptime, loop and frame counters moved to wear-leveled log).|0x0007|0x0013|13|
  * |Length of callsign (uint8_t).|0x0014|0x0014|1|
- * |Callsign (C-string, max MAX_STRING_LENGTH bytes).|0x00015|0x0035|MAX_STRING_LENGTH|
- * |Charging voltage stats (min - avg - max, 3x uint8_t).|0x0040|0x0042|3|
- * |Charging current stats (min - avg - max, 3x int16_t).|0x0043|0x0048|6|
- * |Battery voltage stats (min - avg - max, 3x uint8_t).|0x0049|0x004B|3|
- * |Solar cell A voltage stats (min - avg - max, 3x uint8_t).|0x004C|0x004E|3|
- * |Solar cell B voltage stats (min - avg - max, 3x uint8_t).|0x004F|0x0051|3|
- * |Solar cell C voltage stats (min - avg - max, 3x uint8_t).|0x0052|0x0054|3|
- * |Battery temperature stats (min - avg - max, 3x int16_t).|0x0055|0x005A|6|
- * |Board temperature stats (min - avg - max, 3x int16_t).|0x005B|0x0060|6|
- * |MCU temperature stats (min - avg - max, 3x int8_t).|0x0061|0x0063|3|
- * |Total|||72|
+ * |Callsign (C-string, max MAX_STRING_LENGTH bytes).|0x0015|0x0034|MAX_STRING_LENGTH|
+ * |Listen modem (uint8_t).|0x0035|0x0035|1|
+ * |Sync word profile (uint8_t).|0x0036|0x0036|1|
+ * |Sync word profile expiry (uint32_t, total time in s).|0x0037|0x003A|4|
+ * |Battery capacity (uint16_t, mAh).|0x003B|0x003C|2|
+ * |Legacy stats (min - avg - max, statsBlock_t).|0x0040|0x0063|36|
+ * |Battery charge estimate (float, mAh).|0x0064|0x0067|4|
+ * |Lifetime statistics accumulators (STATS_NUM_CHANNELS x statsAccumulator_t).|0x0068|0x00F7|144|
+ * |Daily statistics accumulators (STATS_NUM_CHANNELS x statsAccumulator_t).|0x00F8|0x0187|144|
+ * |Seconds elapsed in the current daily epoch (uint32_t).|0x0188|0x018B|4|
+ * |Command queue (CMD_QUEUE_NUM_SLOTS x commandQueueEntry_t).|0x018C|0x01FF|116|
+ * |Wear-leveled log of frequently updated values (EEPROM_LOG_NUM_SLOTS x logRecord_t).|0x0200|0x03DB|476|
+ * |Post-mortem record of the last reset (postMortemRecord_t).|0x03DC|0x03E7|12|
+ * |Radio recovery counters (RADIO_RECOVERY_NUM_TIERS x uint16_t).|0x03E8|0x03EF|8|
+ * |Total|||973|
  *
  *
  * @test (ID CONF_EEPROM_ADDR_MAP_T0) (SEV 1) Check that EEPROM_DEPLOYMENT_COUNTER_ADDR is functional, including restarts.
- * @test (ID CONF_EEPROM_ADDR_MAP_T1) (SEV 1) Check that EEPROM_POWER_CONFIG_ADDR is functional, including restarts.
+ * @test (ID CONF_EEPROM_ADDR_MAP_T1) (SEV 1) Check that EEPROM_LOG_ADDR is functional, including restarts.
  * @test (ID CONF_EEPROM_ADDR_MAP_T2) (SEV 1) Check that EEPROM_FIRST_RUN_ADDR is functional, including restarts.
  * @test (ID CONF_EEPROM_ADDR_MAP_T3) (SEV 1) Check that EEPROM_RESTART_COUNTER_ADDR is functional, including restarts.
  * @test (ID CONF_EEPROM_ADDR_MAP_T4) (SEV 1) Check that EEPROM_CALLSIGN_LEN_ADDR is functional, including restarts.
@@ -168,15 +291,15 @@
  * |--|--|
  * |0x0000|0x0000|
  */
-#define EEPROM_DEPLOYMENT_COUNTER_ADDR                  0x0000
+#define EEPROM_DEPLOYMENT_COUNTER_ADDR                  EEPROM_ADDR(config.deploymentCounter)
 
 /**
- * @brief
+ * @brief Layout version, power configuration was stored here in legacy layout.
  * |Start Address|End Address|
  * |--|--|
  * |0x0001|0x0001|
  */
-#define EEPROM_POWER_CONFIG_ADDR                        0x0001
+#define EEPROM_LAYOUT_VERSION_ADDR                      EEPROM_ADDR(config.layoutVersion)
 
 /**
  * @brief
@@ -184,7 +307,7 @@
  * |--|--|
  * |0x0002|0x0002|
  */
-#define EEPROM_FIRST_RUN_ADDR                           0x0002
+#define EEPROM_FIRST_RUN_ADDR                           EEPROM_ADDR(config.firstRun)
 
 /**
  * @brief
@@ -192,7 +315,7 @@
  * |--|--|
  * |0x0003|0x0004|
  */
-#define EEPROM_RESTART_COUNTER_ADDR                     0x0003
+#define EEPROM_RESTART_COUNTER_ADDR                     EEPROM_ADDR(config.restartCounter)
 
 /**
  * @brief
@@ -200,7 +323,7 @@
  * |--|--|
  * |0x0005|0x0005|
  */
-#define EEPROM_FSK_RECEIVE_LEN_ADDR                     0x0005
+#define EEPROM_FSK_RECEIVE_LEN_ADDR                     EEPROM_ADDR(config.fskReceiveLen)
 
 /**
  * @brief
@@ -208,144 +331,127 @@
  * |--|--|
  * |0x0006|0x0006|
  */
-#define EEPROM_LORA_RECEIVE_LEN_ADDR                    0x0006
-
-/**
- * @brief
- * |Start Address|End Address|
- * |--|--|
- * |0x0007|0x000A|
- */
-#define EEPROM_UPTIME_COUNTER_ADDR                      0x0007
-
-/**
- * @brief Loop counter - only used to determine when to transmit full Morse beacon, so it doesn't matter when it overflows.
- * |Start Address|End Address|
- * |--|--|
- * |0x000B|0x000B|
- */
-#define EEPROM_LOOP_COUNTER                             0x000B
-
+#define EEPROM_LORA_RECEIVE_LEN_ADDR                    EEPROM_ADDR(config.loraReceiveLen)
 
 /**
  * @brief
  * |Start Address|End Address|
  * |--|--|
- * |0x000C|0x000D|
+ * |0x0014|0x0014|
  */
-#define EEPROM_LORA_VALID_COUNTER_ADDR                  0x000C
+#define EEPROM_CALLSIGN_LEN_ADDR                        EEPROM_ADDR(config.callsignLen)
 
 /**
  * @brief
  * |Start Address|End Address|
  * |--|--|
- * |0x000E|0x000F|
+ * |0x0015|0x0034|
  */
-#define EEPROM_LORA_INVALID_COUNTER_ADDR                0x000E
+#define EEPROM_CALLSIGN_ADDR                            EEPROM_ADDR(config.callsign)
 
 /**
- * @brief
+ * @brief Modem used to listen during sleep, erased value selects LISTEN_MODEM_DEFAULT.
  * |Start Address|End Address|
  * |--|--|
- * |0x0010|0x0011|
+ * |0x0035|0x0035|
  */
-#define EEPROM_FSK_VALID_COUNTER_ADDR                   0x0010
+#define EEPROM_LISTEN_MODEM_ADDR                        EEPROM_ADDR(config.listenModem)
 
 /**
- * @brief
+ * @brief Sync word profile, erased value selects SYNC_WORD_PROFILE_SHARED.
  * |Start Address|End Address|
  * |--|--|
- * |0x0012|0x0013|
+ * |0x0036|0x0036|
  */
-#define EEPROM_FSK_INVALID_COUNTER_ADDR                 0x0012
+#define EEPROM_SYNC_WORD_PROFILE_ADDR                   EEPROM_ADDR(config.syncWordProfile)
 
 /**
- * @brief
+ * @brief Total time when the sync word profile falls back to SYNC_WORD_PROFILE_SHARED.
  * |Start Address|End Address|
  * |--|--|
- * |0x00014|0x00014|
+ * |0x0037|0x003A|
  */
-#define EEPROM_CALLSIGN_LEN_ADDR                        0x0014
+#define EEPROM_SYNC_WORD_EXPIRY_ADDR                    EEPROM_ADDR(config.syncWordExpiry)
 
 /**
- * @brief
+ * @brief Battery capacity, erased value selects BATTERY_CAPACITY.
  * |Start Address|End Address|
  * |--|--|
- * |0x0015|0x0035|
+ * |0x003B|0x003C|
  */
-#define EEPROM_CALLSIGN_ADDR                            0x0015
+#define EEPROM_BATTERY_CAPACITY_ADDR                    EEPROM_ADDR(config.batteryCapacity)
 
 /**
- * @brief
+ * @brief Minimum, average and maximum stats of layout 0x81 and older, only read during migration.
  * |Start Address|End Address|
  * |--|--|
- * |0x0040|0x0042|
+ * |0x0040|0x0063|
  */
-#define EEPROM_CHARGING_VOLTAGE_STATS_ADDR              0x0040
+#define EEPROM_LEGACY_STATS_ADDR                        EEPROM_ADDR(legacyStats)
 
 /**
- * @brief
+ * @brief Battery charge estimate of the coulomb counter, negative when unknown.
  * |Start Address|End Address|
  * |--|--|
- * |0x0043|0x0048|
+ * |0x0064|0x0067|
  */
-#define EEPROM_CHARGING_CURRENT_STATS_ADDR              0x0043
+#define EEPROM_BATTERY_CHARGE_ADDR                      EEPROM_ADDR(batteryCharge)
 
 /**
- * @brief
+ * @brief Lifetime statistics accumulators (STATS_NUM_CHANNELS x statsAccumulator_t).
  * |Start Address|End Address|
  * |--|--|
- * |0x0049|0x004B|
+ * |0x0068|0x00F7|
  */
-#define EEPROM_BATTERY_VOLTAGE_STATS_ADDR               0x0049
+#define EEPROM_LIFETIME_STATS_ADDR                      EEPROM_ADDR(lifetimeStats)
 
 /**
- * @brief
+ * @brief Daily statistics accumulators (STATS_NUM_CHANNELS x statsAccumulator_t).
  * |Start Address|End Address|
  * |--|--|
- * |0x004C|0x004E|
+ * |0x00F8|0x0187|
  */
-#define EEPROM_CELL_A_VOLTAGE_STATS_ADDR                0x004C
+#define EEPROM_DAILY_STATS_ADDR                         EEPROM_ADDR(dailyStats)
 
 /**
- * @brief
+ * @brief Seconds elapsed in the current daily epoch, updated at the end of each orbit epoch.
  * |Start Address|End Address|
  * |--|--|
- * |0x004F|0x0051|
+ * |0x0188|0x018B|
  */
-#define EEPROM_CELL_B_VOLTAGE_STATS_ADDR                0x004F
+#define EEPROM_DAILY_ELAPSED_ADDR                       EEPROM_ADDR(dailyElapsed)
 
 /**
- * @brief
+ * @brief Time-tagged command queue, erased slots are free.
  * |Start Address|End Address|
  * |--|--|
- * |0x0052|0x0054|
+ * |0x018C|0x01FF|
  */
-#define EEPROM_CELL_C_VOLTAGE_STATS_ADDR                0x0052
+#define EEPROM_COMMAND_QUEUE_ADDR                       EEPROM_ADDR(commandQueue)
 
 /**
- * @brief
+ * @brief Ring of logRecord_t slots, the valid record with the highest sequence number is the current one.
  * |Start Address|End Address|
  * |--|--|
- * |0x0055|0x005A|
+ * |0x0200|0x03DB|
  */
-#define EEPROM_BATTERY_TEMP_STATS_ADDR                  0x0055
+#define EEPROM_LOG_ADDR                                 EEPROM_ADDR(log)
 
 /**
- * @brief
+ * @brief Post-mortem record of the last reset, written on startup.
  * |Start Address|End Address|
  * |--|--|
- * |0x005B|0x0060|
+ * |0x03DC|0x03E7|
  */
-#define EEPROM_BOARD_TEMP_STATS_ADDR                    0x005B
+#define EEPROM_POST_MORTEM_ADDR                         EEPROM_ADDR(postMortem)
 
 /**
- * @brief
+ * @brief Number of radio recovery attempts in each tier, since the last wipe.
  * |Start Address|End Address|
  * |--|--|
- * |0x0061|0x0063|
+ * |0x03E8|0x03EF|
  */
-#define EEPROM_MCU_TEMP_STATS_ADDR                      0x0061
+#define EEPROM_RADIO_RECOVERY_ADDR                      EEPROM_ADDR(radioRecovery)
 
 /**
  * @}
@@ -365,6 +471,154 @@
 #define EEPROM_RESET_VALUE                              0xFF        /*!< EEPROM reset value (255). */
 #define EEPROM_FIRST_RUN                                0           /*!< The value written to the EEPROM address EEPROM_FIRST_RUN_ADDR before the startup sequence. \n See @ref defines_eeprom_address_map */
 #define EEPROM_CONSECUTIVE_RUN                          1           /*!< The value written to the EEPROM address EEPROM_FIRST_RUN_ADDR after the first startup sequence. \n See @ref defines_eeprom_address_map */
+#define EEPROM_LAYOUT_VERSION                           0x84        /*!< Current layout version. Most significant bit is set, so that it can't be mistaken for power configuration stored at the same address in legacy layout. */
+#define EEPROM_CONFIG_CACHE_LEN                         sizeof(configRecord_t)  /*!< Length of configuration block at the start of EEPROM that is kept in RAM. */
+#define EEPROM_LOG_NUM_SLOTS                            28          /*!< Number of log record slots, each write goes to the next one. Multiplies endurance of logged values by this factor. */
+#define EEPROM_SIZE                                     (E2END + 1) /*!< Size of the EEPROM (bytes). */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_eeprom_layout EEPROM Layout
+ *
+ * @brief Records stored in EEPROM. All records are packed, so that their layout is the same on every platform.
+ *
+ * @test (ID CONF_EEPROM_LAYOUT_T0) (SEV 1) Check that a legacy layout is migrated without losing counters.
+ *
+ * @{
+ */
+
+/**
+ * @brief Address of a field in eepromLayout_t.
+ */
+#define EEPROM_ADDR(field)                              offsetof(eepromLayout_t, field)
+
+/**
+ * @brief Configuration block at the start of EEPROM, kept in RAM (see Persistent_Storage_Load_Config).
+ */
+struct configRecord_t {
+  uint8_t deploymentCounter;
+  uint8_t layoutVersion;
+  uint8_t firstRun;
+  uint16_t restartCounter;
+  uint8_t fskReceiveLen;
+  uint8_t loraReceiveLen;
+  uint8_t legacyCounters[13];           // uptime, loop and frame counters in legacy layout
+  uint8_t callsignLen;
+  char callsign[MAX_STRING_LENGTH];
+  uint8_t listenModem;                  // modem used to listen during sleep, see @ref defines_listen
+  uint8_t syncWordProfile;              // see @ref defines_sync_word_profile
+  uint32_t syncWordExpiry;              // total time when the profile falls back to shared (s)
+  uint16_t batteryCapacity;             // mAh, out of range value selects BATTERY_CAPACITY
+} __attribute__((packed));
+
+/**
+ * @brief Minimum, average and maximum of a measured value.
+ */
+template <typename T>
+struct statsRecord_t {
+  T min;
+  T avg;
+  T max;
+} __attribute__((packed));
+
+/**
+ * @brief Statistics of all measured values in layout 0x81 and older.
+ */
+struct statsBlock_t {
+  statsRecord_t<uint8_t> chargingVoltage;
+  statsRecord_t<int16_t> chargingCurrent;
+  statsRecord_t<uint8_t> batteryVoltage;
+  statsRecord_t<uint8_t> cellAVoltage;
+  statsRecord_t<uint8_t> cellBVoltage;
+  statsRecord_t<uint8_t> cellCVoltage;
+  statsRecord_t<int16_t> batteryTemperature;
+  statsRecord_t<int16_t> boardTemperature;
+  statsRecord_t<int8_t> mcuTemperature;
+} __attribute__((packed));
+
+/**
+ * @brief Running statistics of a single channel. Mean and variance are accumulated using Welford's method,
+ * so that they can't overflow. Integer sum of squares would need 64 bits for lifetime statistics, which does not fit
+ * the EEPROM layout. Float is precise enough: samples are only added one by one to the orbit accumulators in RAM,
+ * daily and lifetime accumulators receive them merged per orbit, so the relative update stays far above float
+ * resolution even after years of samples.
+ */
+struct statsAccumulator_t {
+  uint32_t count;                       // number of samples
+  float mean;                           // mean of all samples
+  float m2;                             // sum of squared differences from the mean
+  int16_t min;
+  int16_t max;
+} __attribute__((packed));
+
+/**
+ * @brief Frequently updated values, stored in a ring of EEPROM_LOG_NUM_SLOTS slots starting at EEPROM_LOG_ADDR.
+ * Every save goes to the next slot, so that no single EEPROM cell is rewritten on each loop.
+ */
+struct logRecord_t {
+  uint32_t uptimeCounter;               // total time (s), accumulated over all resets, see Timekeeping_Get_Time
+  uint16_t sequence;                    // incremented on each save, the highest valid one is the current record
+  uint16_t frameCounters[4];            // LoRa valid, LoRa invalid, FSK valid, FSK invalid
+  uint8_t loopCounter;                  // only used to determine when to transmit full Morse beacon, so it doesn't matter when it overflows
+  uint8_t powerConfig;                  // powerConfig_t value
+  uint8_t crc;                          // CRC-8 of all previous bytes
+} __attribute__((packed));
+
+/**
+ * @brief Slot of the time-tagged command queue.
+ */
+struct commandQueueEntry_t {
+  uint32_t time;                        // total time when the command is due, or when it was executed (s)
+  uint8_t state;                        // see @ref defines_command_queue
+  uint8_t id;                           // function ID of the command, response ID once executed (0 if there was none)
+  uint8_t len;                          // length of optional data, full response length once executed
+  uint8_t data[CMD_QUEUE_DATA_LENGTH];  // optional data, or response truncated to CMD_QUEUE_DATA_LENGTH
+} __attribute__((packed));
+
+/**
+ * @brief Cause and context of the last reset, see @ref defines_post_mortem.
+ */
+struct postMortemRecord_t {
+  uint8_t resetFlags;                   // MCUSR of the last reset
+  uint8_t reason;                       // reason of reset requested by the firmware
+  uint8_t phase;                        // scheduler task or phase running at reset
+  uint8_t functionId;                   // function ID being executed at reset
+  int16_t radioError;                   // last RadioLib error code
+  uint32_t time;                        // total time on startup after the reset (s)
+  uint16_t restartCounter;              // value of restart counter on startup after the reset
+} __attribute__((packed));
+
+/**
+ * @brief Complete EEPROM layout, see @ref defines_eeprom_address_map.
+ */
+struct eepromLayout_t {
+  configRecord_t config;
+  uint8_t reserved0[0x03];
+  statsBlock_t legacyStats;
+  float batteryCharge;                  // mAh, negative when unknown
+  statsAccumulator_t lifetimeStats[STATS_NUM_CHANNELS];
+  statsAccumulator_t dailyStats[STATS_NUM_CHANNELS];
+  uint32_t dailyElapsed;
+  commandQueueEntry_t commandQueue[CMD_QUEUE_NUM_SLOTS];
+  logRecord_t log[EEPROM_LOG_NUM_SLOTS];
+  postMortemRecord_t postMortem;
+  uint16_t radioRecovery[RADIO_RECOVERY_NUM_TIERS];
+} __attribute__((packed));
+
+// layout must fit into EEPROM and keep the addresses used by satellites already in orbit
+static_assert(sizeof(eepromLayout_t) <= EEPROM_SIZE, "EEPROM layout is larger than EEPROM!");
+static_assert(sizeof(logRecord_t) == 17, "Unexpected padding in logRecord_t!");
+static_assert(EEPROM_RESTART_COUNTER_ADDR == 0x0003, "Restart counter moved!");
+static_assert(EEPROM_CALLSIGN_LEN_ADDR == 0x0014, "Callsign moved!");
+static_assert(EEPROM_LEGACY_STATS_ADDR == 0x0040, "Legacy stats moved!");
+static_assert(EEPROM_BATTERY_CHARGE_ADDR == 0x0064, "Battery charge moved!");
+static_assert(EEPROM_COMMAND_QUEUE_ADDR == 0x018C, "Command queue moved!");
+static_assert(EEPROM_LOG_ADDR == 0x0200, "Log moved!");
+static_assert(EEPROM_POST_MORTEM_ADDR == 0x03DC, "Post-mortem record moved!");
+static_assert(EEPROM_RADIO_RECOVERY_ADDR == 0x03E8, "Radio recovery counters moved!");
+
 /**
  * @}
  */
@@ -476,6 +730,109 @@
  * @}
  */
 
+/**
+ * @defgroup defines_sync_word_profile Sync Word Profile
+ *
+ * @brief Frames of other stations using SYNC_WORD wake the MCU up. Mission profile uses sync words nobody else should,
+ * so that such frames are dropped by the radio. It is selected over the air for a limited time only, and falls back
+ * to the shared profile when that expires, so the satellite can't be lost because of a ground station misconfiguration.
+ * Duration is capped by SYNC_WORD_MAX_DURATION. Expiry further away than that is not trusted, e.g. when total time
+ * was reset after the log was lost, and selects the shared profile as well.
+ * Independent of the profile, FSK frames are filtered by node address (first callsign character) and maximum length.
+ *
+ * @test (ID CONF_SYNC_WORD_T0) (SEV 1) Check that frames sent with the shared sync word are ignored while mission profile is active.
+ * @test (ID CONF_SYNC_WORD_T1) (SEV 1) Check that shared profile is restored when mission profile expires.
+ * @test (ID CONF_SYNC_WORD_T2) (SEV 1) Check that shared profile is restored when total time is reset while mission profile is active.
+ *
+ * @{
+ */
+#define SYNC_WORD_PROFILE_SHARED                        0           /*!< SYNC_WORD, shared with other stations. */
+#define SYNC_WORD_PROFILE_MISSION                       1           /*!< SYNC_WORD_MISSION and SYNC_WORD_MISSION_FSK. */
+#define SYNC_WORD_MISSION                               0x1B        /*!< LoRa sync word of the mission profile. */
+#define SYNC_WORD_MISSION_FSK                           { 0x1B, 0x46, 0x53, 0x42 }  /*!< FSK sync word of the mission profile. */
+#define SYNC_WORD_MISSION_FSK_LENGTH                    4           /*!< FSK sync word length of the mission profile (bytes). */
+#define SYNC_WORD_MAX_DURATION                          72          /*!< Maximum time the mission profile can be selected for (h). */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_transmit_admission Transmission Energy Admission
+ *
+ * @brief Before each frame is transmitted, its charge is predicted from time-on-air and the transmit current model
+ * (TX_CURRENT_OFFSET + TX_CURRENT_SLOPE * output power, capped at current limit). Frames are admitted while the charge
+ * transmitted in the current pass fits into its budget, TX_BUDGET_SHARE of the battery charge above TX_RESERVE_SOC when
+ * the pass started. A pass starts with the first frame after the previous one lasted TX_BUDGET_PERIOD.
+ *
+ * @test (ID CONF_TX_ADMISSION_T0) (SEV 1) Check that frames are transmitted at TX_REDUCED_OUTPUT_POWER when the margin is not sufficient for full power.
+ * @test (ID CONF_TX_ADMISSION_T1) (SEV 1) Check that frames are not transmitted at all when the margin is not sufficient for reduced power.
+ * @test (ID CONF_TX_ADMISSION_T2) (SEV 1) Check that frames are refused for the rest of the pass once its budget was transmitted.
+ *
+ * @{
+ */
+#define TX_CURRENT_OFFSET                               20.0        /*!< Transmit current model offset (mA). */
+#define TX_CURRENT_SLOPE                                5.0         /*!< Transmit current model slope (mA/dBm). */
+#define TX_RESERVE_SOC                                  10          /*!< State of charge that must remain after transmission (%). */
+#define TX_REDUCED_OUTPUT_POWER                         10          /*!< Output power used when battery margin does not allow full power transmission (dBm). */
+#define TX_ADMIT_FULL                                   0           /*!< Frame transmitted at configured output power. */
+#define TX_ADMIT_REDUCED                                1           /*!< Frame transmitted at TX_REDUCED_OUTPUT_POWER. */
+#define TX_ADMIT_REFUSED                                2           /*!< Frame not transmitted. */
+#define TX_BUDGET_PERIOD                                600         /*!< Length of one pass, starting with its first frame (s). */
+#define TX_BUDGET_SHARE                                 0.02        /*!< Share of the charge margin that may be transmitted in one pass. */
+#define TX_ERR_REFUSED                                  (-30000)    /*!< Status returned by Communication_Transmit for refused frames, outside of RadioLib status codes. */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_nack NACK Policy
+ *
+ * @brief Invalid frames are answered by NACK (acknowledge of function ID 0xFF with the error class as result)
+ * only while the token bucket of the error class has tokens left, so that a noisy band or a misconfigured station
+ * can't drain the battery. Frames for other stations are never answered. All invalid frames are counted per class
+ * and reported in packet info instead.
+ *
+ * @test (ID CONF_NACK_T0) (SEV 1) Check that frames with a different callsign are counted, but not answered.
+ * @test (ID CONF_NACK_T1) (SEV 1) Check that NACKs of a class are sent again after NACK_REFILL_PERIOD.
+ *
+ * @{
+ */
+#define NACK_CALLSIGN                                   0x01        /*!< Callsign does not match, or frame length can't be valid. */
+#define NACK_RX_ERROR                                   0x02        /*!< Frame could not be read from the radio. */
+#define NACK_FUNCTION_ID                                0x03        /*!< Frame has no function ID. */
+#define NACK_DECRYPTION                                 0x04        /*!< Decryption or password check failed. */
+#define NACK_LENGTH                                     0x05        /*!< Optional data length does not match the frame. */
+#define NACK_UNKNOWN_ID                                 0x06        /*!< Function ID is not known. */
+#define NACK_NUM_CLASSES                                6           /*!< Number of error classes. */
+#define NACK_BUCKET_SIZE                                3           /*!< Number of NACKs of one class that can be sent in a burst. */
+#define NACK_REFILL_PERIOD                              300         /*!< Time to regain one NACK of a class (s). */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_listen Wake-on-Packet Listening
+ *
+ * @brief While sleeping between tasks, the radio can sniff for preambles in duty-cycled receive mode and only wake up
+ * when a frame arrives. Ground station has to transmit a preamble at least as long as the one given here.
+ * Listening time of each sleep is limited to what LISTEN_ENERGY_SHARE of the battery charge margin can cover.
+ *
+ * @test (ID CONF_LISTEN_T0) (SEV 1) Check that a frame with long preamble sent during sleep is received and processed.
+ * @test (ID CONF_LISTEN_T1) (SEV 1) Check that there is no listening in critical power mode.
+ *
+ * @{
+ */
+#define LISTEN_DISABLED                                 0           /*!< Listen modem value to disable listening. */
+#define LISTEN_MODEM_DEFAULT                            MODEM_LORA  /*!< Modem used when listen modem was not set yet. */
+#define LISTEN_LORA_PREAMBLE_LENGTH                     256         /*!< Expected preamble of LoRa frames sent to a sleeping satellite (symbols). */
+#define LISTEN_FSK_PREAMBLE_LENGTH                      8192        /*!< Expected preamble of FSK frames sent to a sleeping satellite (bits). */
+#define LISTEN_AVERAGE_CURRENT                          0.5         /*!< Average current of duty-cycled receive (mA). */
+#define LISTEN_RESERVE_SOC                              20          /*!< State of charge that must remain after listening (%). */
+#define LISTEN_ENERGY_SHARE                             0.01        /*!< Share of the charge margin that may be used by one sleep. */
+/**
+ * @}
+ */
+
 /**
  * @defgroup defines_radio_lora_configuration  LoRa Radio Configuration
  *
@@ -586,6 +943,134 @@
  * @}
  */
 
+/**
+ * @defgroup defines_spin_estimation Spin Rate Estimation
+ *
+ * @test (ID CONF_SPIN_T0) (SEV 2) Check that the estimated period matches rotation of the satellite under a light source.
+ *
+ * @{
+ */
+#define SPIN_MAX_SAMPLES                                64          /*!< Maximum number of samples per solar cell in one burst. */
+#define SPIN_MIN_SAMPLES                                8           /*!< Minimum number of samples per solar cell to estimate spin rate. */
+#define SPIN_MIN_CONFIDENCE                             64          /*!< Minimum normalized autocorrelation at detected period (0 - 255). */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_adc_burst ADC Burst Capture
+ *
+ * @brief Solar cells are sampled by Timer1-triggered ADC conversions, results are stored from ADC interrupt.
+ *
+ * @test (ID CONF_ADC_BURST_T0) (SEV 2) Check that the sample rate matches the requested rate up to ADC_BURST_MAX_RATE.
+ * @test (ID CONF_ADC_BURST_T1) (SEV 2) Check that receive windows and transmissions are not affected by running capture.
+ *
+ * @{
+ */
+#define ADC_BURST_MAX_SAMPLES                           40          /*!< Capacity of the capture buffer (samples of all three solar cells). */
+#define ADC_BURST_MAX_RATE                              1000        /*!< Maximum sample rate (Hz). */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_solar_recording Solar Cell Recording
+ *
+ * @brief Slow recording of all solar cells started by CMD_RECORD_SOLAR_CELLS, sampled by a scheduler task in whole seconds.
+ * Each cell voltage is stored as a 4-bit difference from its previous sample, larger changes are stored as
+ * RECORDING_ESCAPE nibble followed by the full 8-bit value, so a sample takes 3 to 9 nibbles. Faster sampling is done
+ * by ADC burst capture.
+ *
+ * @test (ID CONF_RECORDING_T0) (SEV 2) Check that recorded values match solar cell voltages in system info frames.
+ * @test (ID CONF_RECORDING_T1) (SEV 2) Check that recording stops when the buffer is full and all stored samples can be read.
+ *
+ * @{
+ */
+#define RECORDING_MIN_SAMPLES                           40          /*!< Number of samples that fit into the buffer even when every value is escaped. */
+#define RECORDING_BUFFER_LENGTH                         ((RECORDING_MIN_SAMPLES * 3 * 3 + 1) / 2)   /*!< Size of compressed sample buffer (bytes), holds 40 to 120 samples. */
+#define RECORDING_MAX_DELTA                             7           /*!< Largest change stored as a single nibble. */
+#define RECORDING_ESCAPE                                0x08        /*!< Nibble preceding a full 8-bit value. */
+#define RECORDING_PAGE_SAMPLES                          40          /*!< Maximum number of samples in one RESP_RECORDED_SOLAR_CELLS frame. */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_scheduler Task Scheduler
+ *
+ * @brief Task identifiers and default periods. When more tasks are due, the one with the lowest priority value runs first,
+ * default priority is the task identifier. Periodic tasks with non-zero energy cost are postponed by the battery-dependent
+ * sleep interval (see Power_Control_Get_Sleep_Interval) and skipped when the battery charge margin can't cover them.
+ * Essential tasks keep the satellite safe and commandable, so they always stay enabled with a bounded period.
+ *
+ * @test (ID CONF_SCHED_T0) (SEV 1) Check that beacon, system info and receive windows run in this order when due at the same time.
+ * @test (ID CONF_SCHED_T1) (SEV 1) Check that the satellite sleeps between deadlines and that uptime matches wall clock time.
+ *
+ * @{
+ */
+#define SCHED_TASK_BATTERY                              0           /*!< Power mode update and MPPT control. */
+#define SCHED_TASK_SAMPLE                               1           /*!< Sensor sampling into statistics. */
+#define SCHED_TASK_BEACON                               2           /*!< Morse beacon or CW beeps. */
+#define SCHED_TASK_FSK_INFO                             3           /*!< FSK system info frame. */
+#define SCHED_TASK_LORA_INFO                            4           /*!< LoRa system info frame. */
+#define SCHED_TASK_LORA_RECEIVE                         5           /*!< LoRa receive window. */
+#define SCHED_TASK_FSK_RECEIVE                          6           /*!< FSK receive window. */
+#define SCHED_TASK_HOUSEKEEPING                         7           /*!< Uptime, log record, statistics epochs, charge estimate and EEPROM flush. */
+#define SCHED_TASK_DEPLOYMENT                           8           /*!< Automated deployment attempt (one-shot). */
+#define SCHED_TASK_CALIBRATION                          9           /*!< Watchdog timer tick calibration. */
+#define SCHED_TASK_COMMAND_QUEUE                        10          /*!< Execution of due queued commands (one-shot, armed for the nearest target time). */
+#define SCHED_TASK_RECORDING                            11          /*!< Solar cell recording sample (disabled until started, also runs during receive windows). */
+#define SCHED_NUM_TASKS                                 12          /*!< Total number of tasks. */
+#define SCHED_BATTERY_PERIOD                            30          /*!< Default period of battery check (s). */
+#define SCHED_SAMPLE_PERIOD                             60          /*!< Default period of sensor sampling (s). */
+#define SCHED_CYCLE_PERIOD                              80          /*!< Default period of beacon, system info and receive windows, before the sleep interval is added (s). */
+#define SCHED_HOUSEKEEPING_PERIOD                       120         /*!< Default period of housekeeping (s). */
+#define SCHED_DEPLOYMENT_RETRY                          300         /*!< Delay between automated deployment attempts (s). */
+#define SCHED_MIN_PERIOD                                10          /*!< Minimum period of a periodic task that can be set by command (s). */
+#define SCHED_MAX_ESSENTIAL_PERIOD                      600         /*!< Maximum period of an essential task that can be set by command (s). */
+#define SCHED_ESSENTIAL_TASKS                           ((1 << SCHED_TASK_BATTERY) | (1 << SCHED_TASK_LORA_RECEIVE) | (1 << SCHED_TASK_FSK_RECEIVE) | (1 << SCHED_TASK_HOUSEKEEPING))  /*!< Tasks that can't be disabled by command. */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_timekeeping Timekeeping
+ *
+ * @brief Power down sleep is done in 500 ms watchdog timer periods. The actual period depends on supply voltage
+ * and temperature, so it is measured against micros() every TIME_CALIBRATION_PERIOD.
+ *
+ * @test (ID CONF_TIME_T0) (SEV 1) Check that uptime in system info matches wall clock time after several hours of operation.
+ *
+ * @{
+ */
+#define TIME_TICK_DEFAULT_LENGTH                        555555      /*!< Power down period used until the first calibration (us). */
+#define TIME_TICK_MIN_LENGTH                            375000      /*!< Shortest accepted calibration result (us). */
+#define TIME_TICK_MAX_LENGTH                            750000      /*!< Longest accepted calibration result (us). */
+#define TIME_CALIBRATION_PERIOD                         3600        /*!< Period of watchdog timer calibration (s). */
+/**
+ * @}
+ */
+
+/**
+ * @defgroup defines_power_modes Power Modes
+ *
+ * @brief
+ * |Mode|Battery voltage|Behavior|
+ * |--|--|--|
+ * |Normal|above BATTERY_VOLTAGE_LIMIT|All transmissions enabled.|
+ * |Low power|below BATTERY_VOLTAGE_LIMIT|No LoRa system info, halved receive windows.|
+ * |Critical|below BATTERY_CRITICAL_VOLTAGE_LIMIT|As low power, no beacons and no system info.|
+ *
+ * @{
+ */
+#define POWER_MODE_NORMAL                               0
+#define POWER_MODE_LOW                                  1
+#define POWER_MODE_CRITICAL                             2
+#define POWER_MODE_NONE                                 0xFF        /*!< No power mode change is pending. */
+/**
+ * @}
+ */
+
 /**
  * @}
  */
@@ -599,7 +1084,11 @@ extern volatile bool interruptsEnabled;                             /*!< Flag to
 extern volatile bool dataReceived;                                  /*!< Flag to signal data was received from ISR. */
 extern uint8_t currentModem;                                        /*!< Current modem configuration. */
 extern uint8_t spreadingFactorMode;                                 /*!< Current spreading factor mode. */
-extern uint32_t lastHeartbeat;                                      /*!< Timestamp for the watchdog. */
+extern uint8_t txAdmission;                                         /*!< Transmission admission decision of the last frame. */
+extern uint16_t txAdmissionCounters[];                              /*!< Number of frames for each admission decision since restart. */
+extern uint16_t nackCounters[];                                     /*!< Number of invalid frames of each NACK error class since restart. */
+extern uint16_t commandRefusals;                                    /*!< Number of valid commands refused with CMD_REFUSED since restart. */
+extern logRecord_t logRecord;                                       /*!< RAM mirror of the current log record, all reads are served from here. */
 extern INA226 ina;                                                  /*!< INA226 object. */
 extern SX1268 radio;                                                /*!< SX1268 object. */
 extern MorseClient morse;                                           /*!< MorseClient object. */
@@ -0,0 +1,47 @@
+#ifndef CRYPTO_H_INCLUDED
+#define CRYPTO_H_INCLUDED
+
+/**
+ * @file crypto.h
+ * @brief Single-pass decryption of private frames, shared by the satellite and the AES benchmark.
+ * This file must not depend on anything but tiny-AES, so that the benchmark can include it.
+ */
+
+/**
+ * @brief Decrypts encrypted section of a private frame in place, each block only once. Decrypted section is
+ * [length of password and optional data][password][optional data][padding]. Empty section is rejected, since even
+ * commands without optional data must carry the password.
+ *
+ * @test (ID CRYPTO_H_T0) (SEV 1) Check that decrypted optional data match FCP_Get_OptData for frames built by FCP_Encode.
+ * @test (ID CRYPTO_H_T1) (SEV 1) Check that frames with wrong password or length byte, and frames that end after function ID are rejected.
+ *
+ * @param ctx AES context with expanded key schedule.
+ * @param password Transmission password.
+ * @param section Encrypted section of the frame (everything after function ID).
+ * @param sectionLen Length of the encrypted section.
+ * @param optData Set to start of decrypted optional data, unchanged when decryption or password check failed.
+ * @return int16_t Length of optional data, or -1 when decryption or password check failed.
+ */
+static inline int16_t Crypto_Decrypt_Section(struct AES_ctx* ctx, const char* password, uint8_t* section, uint8_t sectionLen, uint8_t** optData) {
+  // encrypted section must be whole blocks, at least one for the length byte and password
+  if((sectionLen == 0) || (sectionLen % AES_BLOCKLEN != 0)) {
+    return(-1);
+  }
+
+  // decrypt in place, each block only once
+  for(uint8_t i = 0; i < sectionLen; i += AES_BLOCKLEN) {
+    AES_ECB_decrypt(ctx, section + i);
+  }
+
+  // check length byte and password
+  uint8_t passwordLen = strlen(password);
+  uint8_t len = section[0];
+  if((len < passwordLen) || (len >= sectionLen) || (memcmp(section + 1, password, passwordLen) != 0)) {
+    return(-1);
+  }
+
+  *optData = section + 1 + passwordLen;
+  return(len - passwordLen);
+}
+
+#endif
@@ -16,4 +16,5 @@ void Deployment_Deploy() {
 
   // increment reset counter
   Persistent_Storage_Write<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR, Persistent_Storage_Read<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR) + 1);
+  Persistent_Storage_Flush();
 }
@@ -1,28 +1,207 @@
 #include "persistent_storage.h"
 
+// RAM copy of the configuration block, one dirty bit per byte
+uint8_t configCache[EEPROM_CONFIG_CACHE_LEN];
+uint8_t configDirty[(EEPROM_CONFIG_CACHE_LEN + 7) / 8];
+
+// number of bytes written by flush
+uint16_t configFlushCounter = 0;
+
+void Persistent_Storage_Read_Bytes(uint16_t addr, uint8_t* data, uint8_t len) {
+  for(uint8_t i = 0; i < len; i++, addr++) {
+    if(addr < EEPROM_CONFIG_CACHE_LEN) {
+      data[i] = configCache[addr];
+    } else {
+      data[i] = EEPROM.read(addr);
+    }
+  }
+}
+
+void Persistent_Storage_Write_Bytes(uint16_t addr, const uint8_t* data, uint8_t len) {
+  for(uint8_t i = 0; i < len; i++, addr++) {
+    if(addr >= EEPROM_CONFIG_CACHE_LEN) {
+      EEPROM.update(addr, data[i]);
+
+    } else if(configCache[addr] != data[i]) {
+      // only bytes that actually changed will be written
+      configCache[addr] = data[i];
+      configDirty[addr / 8] |= (1 << (addr % 8));
+    }
+  }
+}
+
+void Persistent_Storage_Load_Config() {
+  for(uint16_t addr = 0; addr < EEPROM_CONFIG_CACHE_LEN; addr++) {
+    configCache[addr] = EEPROM.read(addr);
+  }
+  memset(configDirty, 0, sizeof(configDirty));
+}
+
+const uint8_t* Persistent_Storage_Get_Config(uint16_t addr) {
+  return(&configCache[addr]);
+}
+
+void Persistent_Storage_Flush() {
+  for(uint16_t addr = 0; addr < EEPROM_CONFIG_CACHE_LEN; addr++) {
+    if(configDirty[addr / 8] & (1 << (addr % 8))) {
+      EEPROM.write(addr, configCache[addr]);
+      configFlushCounter++;
+    }
+  }
+  memset(configDirty, 0, sizeof(configDirty));
+}
+
+// RAM mirror of the current log record
+logRecord_t logRecord;
+
+// slot of the current log record
+uint8_t logSlot = EEPROM_LOG_NUM_SLOTS - 1;
+
+static uint8_t Persistent_Storage_Log_CRC(const logRecord_t& rec) {
+  // CRC-8, polynomial 0x07
+  const uint8_t* ptr = (const uint8_t*)&rec;
+  uint8_t crc = 0x00;
+  for(uint8_t i = 0; i < offsetof(logRecord_t, crc); i++) {
+    crc ^= ptr[i];
+    for(uint8_t j = 0; j < 8; j++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+    }
+  }
+  return(crc);
+}
+
+bool Persistent_Storage_Load_Log() {
+  bool found = false;
+  for(uint8_t slot = 0; slot < EEPROM_LOG_NUM_SLOTS; slot++) {
+    logRecord_t rec = Persistent_Storage_Read<logRecord_t>(EEPROM_LOG_ADDR + slot*sizeof(logRecord_t));
+    if(rec.crc != Persistent_Storage_Log_CRC(rec)) {
+      // empty or interrupted write
+      continue;
+    }
+
+    // sequence comparison survives overflow
+    if(!found || ((int16_t)(rec.sequence - logRecord.sequence) > 0)) {
+      logRecord = rec;
+      logSlot = slot;
+      found = true;
+    }
+  }
+
+  if(!found) {
+    FOSSASAT_DEBUG_PRINTLN(F("Log empty"));
+    memset(&logRecord, 0, sizeof(logRecord));
+    logRecord.powerConfig = powerConfig.val;
+    logSlot = EEPROM_LOG_NUM_SLOTS - 1;
+  }
+
+  return(found);
+}
+
+template <typename T>
+static statsAccumulator_t Persistent_Storage_Migrate_Stats(statsRecord_t<T> legacy) {
+  statsAccumulator_t stats = { 0, 0, 0, INT16_MAX, INT16_MIN };
+  if((legacy.min == 0) && (legacy.avg == 0) && (legacy.max == 0)) {
+    // wiped, no samples
+    return(stats);
+  }
+
+  stats.count = 1;
+  stats.mean = legacy.avg;
+  stats.min = legacy.min;
+  stats.max = legacy.max;
+  return(stats);
+}
+
+void Persistent_Storage_Migrate(bool logFound) {
+  uint8_t version = Persistent_Storage_Read<uint8_t>(EEPROM_LAYOUT_VERSION_ADDR);
+  if(version == EEPROM_LAYOUT_VERSION) {
+    return;
+  }
+  FOSSASAT_DEBUG_PRINT(F("Mig "));
+  FOSSASAT_DEBUG_PRINTLN(version, HEX);
+
+  // legacy layout had power configuration in place of version
+  if(!(version & 0x80) && !logFound) {
+    uint16_t legacyAddr = EEPROM_ADDR(config.legacyCounters);
+    powerConfig.val = version;
+    Timekeeping_Set_Time(Persistent_Storage_Read<uint32_t>(legacyAddr));
+    logRecord.loopCounter = Persistent_Storage_Read<uint8_t>(legacyAddr + sizeof(uint32_t));
+    Persistent_Storage_Read_Bytes(legacyAddr + sizeof(uint32_t) + sizeof(uint8_t), (uint8_t*)logRecord.frameCounters, sizeof(logRecord.frameCounters));
+    Power_Control_Save_Configuration();
+  }
+
+  // layout 0x81 and older had minimum, average and maximum stats only, use them as the first sample
+  if((version <= 0x81) || (version == EEPROM_RESET_VALUE)) {
+    statsBlock_t legacy = Persistent_Storage_Read<statsBlock_t>(EEPROM_LEGACY_STATS_ADDR);
+    statsAccumulator_t stats[STATS_NUM_CHANNELS];
+    stats[STATS_CHARGING_VOLTAGE] = Persistent_Storage_Migrate_Stats(legacy.chargingVoltage);
+    stats[STATS_CHARGING_CURRENT] = Persistent_Storage_Migrate_Stats(legacy.chargingCurrent);
+    stats[STATS_BATTERY_VOLTAGE] = Persistent_Storage_Migrate_Stats(legacy.batteryVoltage);
+    stats[STATS_CELL_A_VOLTAGE] = Persistent_Storage_Migrate_Stats(legacy.cellAVoltage);
+    stats[STATS_CELL_B_VOLTAGE] = Persistent_Storage_Migrate_Stats(legacy.cellBVoltage);
+    stats[STATS_CELL_C_VOLTAGE] = Persistent_Storage_Migrate_Stats(legacy.cellCVoltage);
+    stats[STATS_BATTERY_TEMP] = Persistent_Storage_Migrate_Stats(legacy.batteryTemperature);
+    stats[STATS_BOARD_TEMP] = Persistent_Storage_Migrate_Stats(legacy.boardTemperature);
+    stats[STATS_MCU_TEMP] = Persistent_Storage_Migrate_Stats(legacy.mcuTemperature);
+    Persistent_Storage_Write_Bytes(EEPROM_LIFETIME_STATS_ADDR, (uint8_t*)stats, sizeof(stats));
+  }
+
+  // layout 0x82 and older had lifetime stats only
+  if((version <= 0x82) || (version == EEPROM_RESET_VALUE)) {
+    Statistics_Reset(STATS_EPOCH_DAY);
+  }
+
+  // layout 0x83 and older had no radio recovery counters
+  uint16_t radioRecovery[RADIO_RECOVERY_NUM_TIERS] = { 0, 0, 0, 0 };
+  Persistent_Storage_Write_Bytes(EEPROM_RADIO_RECOVERY_ADDR, (uint8_t*)radioRecovery, sizeof(radioRecovery));
+
+  Persistent_Storage_Write<uint8_t>(EEPROM_LAYOUT_VERSION_ADDR, EEPROM_LAYOUT_VERSION);
+  Persistent_Storage_Flush();
+}
+
+void Persistent_Storage_Save_Log() {
+  // write to the next slot, the previous record stays valid until this one is complete
+  logSlot = (logSlot + 1) % EEPROM_LOG_NUM_SLOTS;
+  logRecord.uptimeCounter = Timekeeping_Get_Time();
+  logRecord.sequence++;
+  logRecord.crc = Persistent_Storage_Log_CRC(logRecord);
+  Persistent_Storage_Write<logRecord_t>(EEPROM_LOG_ADDR + logSlot*sizeof(logRecord_t), logRecord);
+}
+
 void Persistent_Storage_Wipe() {
   // wipe EEPROM
   FOSSASAT_DEBUG_PRINTLN('W');
   for (uint16_t i = 0; i < EEPROM.length(); i++) {
-    Persistent_Storage_Write<uint8_t>(i, EEPROM_RESET_VALUE);
+    EEPROM.update(i, EEPROM_RESET_VALUE);
   }
 
+  // drop pending configuration changes
+  Persistent_Storage_Load_Config();
+
   // set default variable values
 
   // set deployment counter to 0
   Persistent_Storage_Write<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR, 0);
 
+  // log is empty now, start a new one with zero time, loop and frame counters
+  Persistent_Storage_Load_Log();
+  Timekeeping_Set_Time(0);
+
   // set default power configuration
   powerConfig.bits.lowPowerModeActive = LOW_POWER_MODE_ACTIVE;
   powerConfig.bits.lowPowerModeEnabled = LOW_POWER_MODE_ENABLED;
   powerConfig.bits.mpptTempSwitchEnabled = MPPT_TEMP_SWITCH_ENABLED;
   powerConfig.bits.mpptKeepAliveEnabled = MPPT_KEEP_ALIVE_ENABLED;
   powerConfig.bits.transmitEnabled = TRANSMIT_ENABLED;
+  powerConfig.bits.criticalModeActive = CRITICAL_MODE_ACTIVE;
   Power_Control_Save_Configuration();
 
   // reset first run flag
   Persistent_Storage_Write<uint8_t>(EEPROM_FIRST_RUN_ADDR, EEPROM_FIRST_RUN);
 
+  // set current layout version
+  Persistent_Storage_Write<uint8_t>(EEPROM_LAYOUT_VERSION_ADDR, EEPROM_LAYOUT_VERSION);
+
   // set reset counter to 0
   Persistent_Storage_Write<uint16_t>(EEPROM_RESTART_COUNTER_ADDR, 0);
 
@@ -30,26 +209,34 @@ void Persistent_Storage_Wipe() {
   Persistent_Storage_Write<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR, FSK_RECEIVE_WINDOW_LENGTH);
   Persistent_Storage_Write<uint8_t>(EEPROM_LORA_RECEIVE_LEN_ADDR, LORA_RECEIVE_WINDOW_LENGTH);
 
-  // reset uptime counter
-  Persistent_Storage_Write<uint32_t>(EEPROM_UPTIME_COUNTER_ADDR, 0);
+  // set default listen modem
+  Persistent_Storage_Write<uint8_t>(EEPROM_LISTEN_MODEM_ADDR, LISTEN_MODEM_DEFAULT);
 
-  // reset loop counter
-  Persistent_Storage_Write<uint8_t>(EEPROM_LOOP_COUNTER, 0);
+  // set shared sync word
+  Persistent_Storage_Write<uint8_t>(EEPROM_SYNC_WORD_PROFILE_ADDR, SYNC_WORD_PROFILE_SHARED);
 
-  // reset frame counters
-  Persistent_Storage_Write<uint16_t>(EEPROM_LORA_VALID_COUNTER_ADDR, 0);
-  Persistent_Storage_Write<uint16_t>(EEPROM_LORA_INVALID_COUNTER_ADDR, 0);
-  Persistent_Storage_Write<uint16_t>(EEPROM_FSK_VALID_COUNTER_ADDR, 0);
-  Persistent_Storage_Write<uint16_t>(EEPROM_FSK_INVALID_COUNTER_ADDR, 0);
+  // set default battery capacity
+  Persistent_Storage_Write<uint16_t>(EEPROM_BATTERY_CAPACITY_ADDR, BATTERY_CAPACITY);
 
   // set default callsign
-  System_Info_Set_Callsign((char*)"FOSSASAT-1B");
+  System_Info_Set_Callsign((char*)"FOSSASAT-1B", 11);
 
   // reset stats
-  for(uint16_t addr = EEPROM_CHARGING_VOLTAGE_STATS_ADDR; addr <= EEPROM_MCU_TEMP_STATS_ADDR + 2; addr += sizeof(uint32_t)) {
-    Persistent_Storage_Write<uint32_t>(addr, 0);
+  for(uint8_t epoch = 0; epoch < STATS_NUM_EPOCHS; epoch++) {
+    Statistics_Reset(epoch);
   }
 
+  // reset radio recovery counters
+  uint16_t radioRecovery[RADIO_RECOVERY_NUM_TIERS] = { 0, 0, 0, 0 };
+  Persistent_Storage_Write_Bytes(EEPROM_RADIO_RECOVERY_ADDR, (uint8_t*)radioRecovery, sizeof(radioRecovery));
+
+  // reset battery charge estimate, will be initialized from the next rest voltage reading
+  Persistent_Storage_Write<float>(EEPROM_BATTERY_CHARGE_ADDR, -1.0);
+  Power_Control_Load_Charge();
+
+  // write default configuration
+  Persistent_Storage_Flush();
+
 }
 
 void Persistent_Storage_Increment_Counter(uint16_t addr) {
@@ -57,18 +244,18 @@ void Persistent_Storage_Increment_Counter(uint16_t addr) {
 }
 
 void Persistent_Storage_Increment_Frame_Counter(bool valid) {
-  uint16_t addr = EEPROM_LORA_VALID_COUNTER_ADDR;
+  uint8_t index = 0;
   if(currentModem == MODEM_LORA) {
     if(!valid) {
-      addr += 2;
+      index = 1;
     }
   } else {
     if(valid) {
-      addr += 4;
+      index = 2;
     } else {
-      addr += 6;
+      index = 3;
     }
   }
 
-  Persistent_Storage_Increment_Counter(addr);
+  logRecord.frameCounters[index]++;
 }
@@ -11,6 +11,31 @@
  * @brief This module controls access to the EEPROM.
  */
 
+/**
+ * @brief Number of bytes written to EEPROM by Persistent_Storage_Flush since restart.
+ *
+ */
+extern uint16_t configFlushCounter;
+
+/**
+ * @brief Reads bytes from EEPROM. Bytes in the configuration block (below EEPROM_CONFIG_CACHE_LEN) are read from RAM.
+ *
+ * @param addr Memory address.
+ * @param data Destination buffer.
+ * @param len Number of bytes to read.
+ */
+void Persistent_Storage_Read_Bytes(uint16_t addr, uint8_t* data, uint8_t len);
+
+/**
+ * @brief Writes bytes to EEPROM. Bytes in the configuration block are only updated in RAM and marked dirty when changed,
+ * EEPROM is updated on the next Persistent_Storage_Flush.
+ *
+ * @param addr Memory address.
+ * @param data Bytes to write.
+ * @param len Number of bytes to write.
+ */
+void Persistent_Storage_Write_Bytes(uint16_t addr, const uint8_t* data, uint8_t len);
+
 /**
  * @brief This function reads a value of type T from EEPROM.
  *
@@ -21,7 +46,7 @@
 template <typename T>
 T Persistent_Storage_Read(uint16_t addr) {
   T val;
-  EEPROM.get(addr, val);
+  Persistent_Storage_Read_Bytes(addr, (uint8_t*)&val, sizeof(T));
   return(val);
 }
 
@@ -34,9 +59,32 @@ T Persistent_Storage_Read(uint16_t addr) {
  */
 template <typename T>
 void Persistent_Storage_Write(uint16_t addr, T val) {
-  EEPROM.put(addr, val);
+  Persistent_Storage_Write_Bytes(addr, (const uint8_t*)&val, sizeof(T));
 }
 
+/**
+ * @brief Loads the configuration block from EEPROM into RAM. Must be called before any other access.
+ *
+ */
+void Persistent_Storage_Load_Config();
+
+/**
+ * @brief Gets the RAM copy of the configuration block, so that it can be read in place. Changes must be written
+ * through Persistent_Storage_Write, otherwise they would not be saved.
+ *
+ * @param addr Memory address, must be below EEPROM_CONFIG_CACHE_LEN.
+ * @return const uint8_t* Pointer to the cached byte.
+ */
+const uint8_t* Persistent_Storage_Get_Config(uint16_t addr);
+
+/**
+ * @brief Writes dirty bytes of the configuration block to EEPROM.
+ *
+ * @test (ID PERSIS_STOR_H_T3) (SEV 1) Check that configuration changed by a command survives restart.
+ *
+ */
+void Persistent_Storage_Flush();
+
 /**
  * @brief This functions clears the EEPROM by writing EEPROM_RESET_VALUE to each memory addres.
  *
@@ -46,44 +94,49 @@ void Persistent_Storage_Write(uint16_t addr, T val) {
 void Persistent_Storage_Wipe();
 
 /**
- * @brief This functions increments 2-byte counter in EEPROM
+ * @brief Finds the valid log record with the highest sequence number and loads it into logRecord.
+ * If there is none (first run or wiped EEPROM), logRecord is initialized with zero counters and the current powerConfig.
  *
- * @param addr The address of counter to increment
+ * @test (ID PERSIS_STOR_H_T1) (SEV 1) Check that the latest record is recovered after a restart during save.
  *
+ * @return bool Whether a valid record was found.
  */
-void Persistent_Storage_Increment_Counter(uint16_t addr);
+bool Persistent_Storage_Load_Log();
 
 /**
- * @brief This functions increments one of frame counters of the currently active modem in EEPROM
+ * @brief Converts EEPROM contents written by an older firmware to the current layout (EEPROM_LAYOUT_VERSION).
+ * Legacy layout stored power configuration, uptime, loop and frame counters at fixed addresses,
+ * these are moved into the log unless it already contains a valid record.
  *
- * @param valid Whether to increment valid or invalid counter
+ * @test (ID PERSIS_STOR_H_T4) (SEV 1) Check that the migration is only performed once.
  *
+ * @param logFound Whether Persistent_Storage_Load_Log found a valid record.
  */
-void Persistent_Storage_Increment_Frame_Counter(bool valid);
+void Persistent_Storage_Migrate(bool logFound);
 
 /**
- * @brief Updates minimum, average and maximum stats in EEPROM
+ * @brief Writes logRecord to the next slot of the log, with the current total time.
  *
- * @tparam T
- * @param addr Memory address.
- * @param val
+ * @test (ID PERSIS_STOR_H_T2) (SEV 1) Check that the log wraps around after EEPROM_LOG_NUM_SLOTS saves.
  *
  */
-template <typename T>
-void Persistent_Storage_Update_Stats(uint16_t addr, T val) {
-  T min = Persistent_Storage_Read<T>(addr);
-  T avg = Persistent_Storage_Read<T>(addr + sizeof(val));
-  T max = Persistent_Storage_Read<T>(addr + 2*sizeof(val));
+void Persistent_Storage_Save_Log();
 
-  if(val < min) {
-    Persistent_Storage_Write<T>(addr, val);
-  }
-
-  Persistent_Storage_Write<T>(addr + sizeof(val), (avg + val)/2);
+/**
+ * @brief This functions increments 2-byte counter in EEPROM
+ *
+ * @param addr The address of counter to increment
+ *
+ */
+void Persistent_Storage_Increment_Counter(uint16_t addr);
 
-  if(val > max) {
-    Persistent_Storage_Write<T>(addr + 2*sizeof(val), val);
-  }
-}
+/**
+ * @brief This functions increments one of frame counters of the currently active modem in logRecord.
+ * The counter is saved together with the next log save.
+ *
+ * @param valid Whether to increment valid or invalid counter
+ *
+ */
+void Persistent_Storage_Increment_Frame_Counter(bool valid);
 
 #endif
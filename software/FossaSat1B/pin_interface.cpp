@@ -1,5 +1,57 @@
 #include "pin_interface.h"
 
+// ADC burst capture ring buffer and state
+volatile uint8_t adcBurstBuffer[3 * ADC_BURST_MAX_SAMPLES];
+volatile uint8_t adcBurstHead = 0;
+volatile uint8_t adcBurstCount = 0;
+volatile uint16_t adcBurstRemaining = 0;
+volatile uint8_t adcBurstChannel = 0;
+volatile bool adcBurstActive = false;
+
+// latest sample of each solar cell
+volatile uint8_t adcBurstLatest[3] = { 0, 0, 0 };
+
+// order in which solar cells are converted
+static const uint8_t adcBurstMux[3] = { ANALOG_IN_SOLAR_A_VOLTAGE_PIN - A0, ANALOG_IN_SOLAR_B_VOLTAGE_PIN - A0, ANALOG_IN_SOLAR_C_VOLTAGE_PIN - A0 };
+
+// cppcheck-suppress unusedFunction
+ISR(ADC_vect) {
+  // clear compare flag, conversions are triggered by its rising edge
+  TIFR1 = _BV(OCF1B);
+
+  // store left-adjusted 8-bit result
+  uint8_t val = ADCH;
+  adcBurstBuffer[adcBurstHead] = val;
+  adcBurstLatest[adcBurstChannel] = val;
+  adcBurstHead = (adcBurstHead + 1) % sizeof(adcBurstBuffer);
+  if(adcBurstCount < sizeof(adcBurstBuffer)) {
+    adcBurstCount++;
+  }
+
+  // select next solar cell
+  adcBurstChannel = (adcBurstChannel + 1) % 3;
+  ADMUX = _BV(REFS0) | _BV(ADLAR) | adcBurstMux[adcBurstChannel];
+
+  // check capture length
+  if((adcBurstRemaining > 0) && (--adcBurstRemaining == 0)) {
+    Pin_Interface_ADC_Burst_Stop();
+  }
+}
+
+// number of heartbeats left until the liveness deadline
+volatile uint32_t watchdogLiveness = 0;
+
+// Timer2 compare matches since the last heartbeat
+volatile uint8_t watchdogTicks = 0;
+
+// cppcheck-suppress unusedFunction
+ISR(TIMER2_COMPA_vect) {
+  if(++watchdogTicks >= WATCHDOG_LOOP_HEARTBEAT_PERIOD / WATCHDOG_TIMER_TICK) {
+    watchdogTicks = 0;
+    Pin_Interface_Watchdog_Service();
+  }
+}
+
 void Pin_Interface_Set_Temp_Resolution(uint8_t sensorAddr, uint8_t res) {
   // set resolution
   Wire.beginTransmission(sensorAddr);
@@ -26,6 +78,12 @@ float Pin_Interface_Read_Temperature(uint8_t sensorAddr) {
 }
 
 int8_t Pin_Interface_Read_Temperature_Internal() {
+  // ADC is owned by burst capture
+  static int8_t lastTemp = 0;
+  if(adcBurstActive) {
+    return(lastTemp);
+  }
+
   // select temperature sensor and reference
   ADMUX = _BV(REFS1) | _BV(REFS0) | _BV(MUX3);
   // start AD conversion
@@ -37,14 +95,98 @@ int8_t Pin_Interface_Read_Temperature_Internal() {
 
   // convert to real temperature
   int8_t temp = (int8_t)(((float)raw - MCU_TEMP_OFFSET) / MCU_TEMP_COEFFICIENT);
+  lastTemp = temp;
   return(temp);
 }
 
 float Pin_Interface_Read_Voltage(uint8_t pin) {
+  // ADC is owned by burst capture, use its latest sample
+  if(adcBurstActive) {
+    for(uint8_t i = 0; i < 3; i++) {
+      if(adcBurstMux[i] == pin - A0) {
+        return((adcBurstLatest[i] * 3.3) / 255.0);
+      }
+    }
+  }
+
   // map ADC value to voltage
   return((analogRead(pin) * 3.3) / 1023.0);
 }
 
+bool Pin_Interface_ADC_Burst_Start(uint16_t rate, uint8_t numSamples) {
+  if((rate == 0) || (rate > ADC_BURST_MAX_RATE) || (numSamples > ADC_BURST_MAX_SAMPLES)) {
+    return(false);
+  }
+  Pin_Interface_ADC_Burst_Stop();
+
+  // reset buffer
+  adcBurstHead = 0;
+  adcBurstCount = 0;
+  adcBurstChannel = 0;
+  adcBurstRemaining = 3 * (uint16_t)numSamples;
+
+  // first channel, AVcc reference, left-adjusted result
+  ADMUX = _BV(REFS0) | _BV(ADLAR) | adcBurstMux[0];
+
+  // Timer1 in CTC mode with prescaler 64, compare match B once per conversion
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  OCR1A = (F_CPU / 64UL) / (3UL * rate) - 1;
+  OCR1B = OCR1A;
+  TIFR1 = _BV(OCF1B);
+  TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+
+  // ADC auto-triggered by Timer1 compare match B, with interrupt
+  ADCSRB = _BV(ADTS2) | _BV(ADTS0);
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1);
+  adcBurstActive = true;
+  interrupts();
+
+  FOSSASAT_DEBUG_PRINT(F("ADC "));
+  FOSSASAT_DEBUG_PRINTLN(OCR1A);
+  return(true);
+}
+
+void Pin_Interface_ADC_Burst_Stop() {
+  // stop Timer1
+  TCCR1B = 0;
+
+  // back to single conversions as set up by Arduino core
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1);
+  ADCSRB = 0;
+  adcBurstActive = false;
+}
+
+bool Pin_Interface_ADC_Burst_Active() {
+  return(adcBurstActive);
+}
+
+uint8_t Pin_Interface_ADC_Burst_Read(uint8_t* buff) {
+  noInterrupts();
+
+  // buffer index of a sample determines its cell, skip the partial triple left by a wrapped capture
+  uint8_t start = (adcBurstHead + sizeof(adcBurstBuffer) - adcBurstCount) % sizeof(adcBurstBuffer);
+  uint8_t skip = (3 - start % 3) % 3;
+  uint8_t count = (adcBurstCount > skip) ? adcBurstCount - skip : 0;
+  start = (start + skip) % sizeof(adcBurstBuffer);
+
+  // only complete samples of all three cells
+  uint8_t len = count - (count % 3);
+  for(uint8_t i = 0; i < len; i++) {
+    buff[i] = adcBurstBuffer[(start + i) % sizeof(adcBurstBuffer)];
+  }
+
+  interrupts();
+
+  // convert outside of the critical section
+  for(uint8_t i = 0; i < len; i++) {
+    buff[i] = ((buff[i] * 3.3) / 255.0) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
+  }
+  return(len);
+}
+
 void Pin_Interface_Watchdog_Heartbeat(bool manageBattery) {
   // toggle watchdog pin
   digitalWrite(DIGITAL_OUT_WATCHDOG_HEARTBEAT, !digitalRead(DIGITAL_OUT_WATCHDOG_HEARTBEAT));
@@ -55,11 +197,60 @@ void Pin_Interface_Watchdog_Heartbeat(bool manageBattery) {
   }
 }
 
-void Pin_Interface_Watchdog_Restart() {
-  FOSSASAT_DEBUG_PRINTLN(F("Rst"));
-  
-  // do not pet watchdog for more than 30 seconds to restart
-  for(uint8_t i = 0; i < WATCHDOG_RESET_NUM_SLEEP_CYCLES; i++) {
-    LowPower.powerDown(SLEEP_8S, ADC_OFF, BOD_OFF);
+void Pin_Interface_Watchdog_Start() {
+  Pin_Interface_Watchdog_Check_In();
+
+  // Timer2 in CTC mode, prescaler 1024
+  noInterrupts();
+  TCCR2A = _BV(WGM21);
+  TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20);
+  OCR2A = (F_CPU / 1024UL) * WATCHDOG_TIMER_TICK / 1000UL - 1;
+  TCNT2 = 0;
+  TIMSK2 = _BV(OCIE2A);
+  interrupts();
+}
+
+void Pin_Interface_Watchdog_Service() {
+  // may be called from main code while Timer2 interrupt is pending
+  uint8_t sreg = SREG;
+  noInterrupts();
+  if(watchdogLiveness > 0) {
+    watchdogLiveness--;
+    Pin_Interface_Watchdog_Heartbeat();
+  }
+  SREG = sreg;
+}
+
+void Pin_Interface_Watchdog_Check_In() {
+  noInterrupts();
+  watchdogLiveness = (uint32_t)WATCHDOG_LIVENESS_DEADLINE * 1000UL / WATCHDOG_LOOP_HEARTBEAT_PERIOD;
+  interrupts();
+}
+
+void Pin_Interface_Watchdog_Extend(uint32_t ms) {
+  uint32_t beats = ms / WATCHDOG_LOOP_HEARTBEAT_PERIOD + 1;
+  noInterrupts();
+  if(watchdogLiveness < beats) {
+    watchdogLiveness = beats;
   }
+  interrupts();
+}
+
+void Pin_Interface_Watchdog_Restart(uint8_t reason) {
+  FOSSASAT_DEBUG_PRINTLN(F("Rst"));
+  Post_Mortem_Set_Reason(reason);
+
+  // stop signalling the external watchdog, it will reset the MCU if the internal one fails
+  noInterrupts();
+  watchdogLiveness = 0;
+  interrupts();
+
+  // save everything that was only changed in RAM
+  Statistics_Flush();
+  Persistent_Storage_Flush();
+  Persistent_Storage_Save_Log();
+
+  // reset by internal watchdog in system reset mode
+  wdt_enable(WDTO_15MS);
+  while(true);
 }
@@ -49,6 +49,41 @@ int8_t Pin_Interface_Read_Temperature_Internal();
  */
 float Pin_Interface_Read_Voltage(uint8_t pin);
 
+/**
+ * @brief Starts background capture of all solar cells. Conversions are triggered by Timer1 and stored from ADC interrupt
+ * into a ring buffer of ADC_BURST_MAX_SAMPLES samples with 8-bit resolution.
+ *
+ * @test (ID PIN_INTERF_H_T8) (SEV 2) Make sure capture stops by itself after the requested number of samples.
+ *
+ * @param rate Sample rate (Hz), at most ADC_BURST_MAX_RATE.
+ * @param numSamples Number of samples to capture, 0 to keep capturing the latest ADC_BURST_MAX_SAMPLES until stopped.
+ * @return bool Whether capture was started.
+ */
+bool Pin_Interface_ADC_Burst_Start(uint16_t rate, uint8_t numSamples);
+
+/**
+ * @brief Stops background capture and returns ADC to the configuration expected by analogRead.
+ *
+ */
+void Pin_Interface_ADC_Burst_Stop();
+
+/**
+ * @brief Checks whether background capture is running.
+ *
+ * @return bool Whether background capture is running.
+ */
+bool Pin_Interface_ADC_Burst_Active();
+
+/**
+ * @brief Copies captured samples in chronological order as A, B, C voltages (see FOSSA-Comms VOLTAGE_UNIT).
+ *
+ * @test (ID PIN_INTERF_H_T9) (SEV 2) Make sure the oldest sample is first after buffer wrapped around.
+ *
+ * @param buff Destination buffer, at least 3 * ADC_BURST_MAX_SAMPLES bytes.
+ * @return uint8_t Number of bytes copied.
+ */
+uint8_t Pin_Interface_ADC_Burst_Read(uint8_t* buff);
+
 /**
  * @brief This function toggles the signal to the watchdog and writes it to the pin.
  * 
@@ -57,12 +92,44 @@ float Pin_Interface_Read_Voltage(uint8_t pin);
  * @param manageBattery Whether to perform battery and power management.
  */
 void Pin_Interface_Watchdog_Heartbeat(bool manageBattery = false);
+
+/**
+ * @brief Starts Timer2 interrupt that signals the watchdog every WATCHDOG_LOOP_HEARTBEAT_PERIOD, as long as the main loop
+ * keeps checking in. No other code has to signal the watchdog.
+ *
+ * @test (ID PIN_INTERF_H_T10) (SEV 1) Make sure the watchdog is signalled during long transmissions without manual calls.
+ *
+ */
+void Pin_Interface_Watchdog_Start();
+
+/**
+ * @brief Signals the watchdog if the liveness deadline did not pass. Called from Timer2 interrupt while awake,
+ * and after each power down period, when Timer2 is stopped.
+ *
+ */
+void Pin_Interface_Watchdog_Service();
+
+/**
+ * @brief Renews liveness token, the watchdog will be signalled for the next WATCHDOG_LIVENESS_DEADLINE.
+ *
+ */
+void Pin_Interface_Watchdog_Check_In();
+
+/**
+ * @brief Extends liveness token to cover a planned sleep or a requested long operation, without renewing the full deadline.
+ * Only the scheduler sleep, the pre-deployment sleep and spin estimation burst are planned, ordinary delays must fit
+ * into the deadline.
+ *
+ * @param ms Sleep or operation length (ms).
+ */
+void Pin_Interface_Watchdog_Extend(uint32_t ms);
 /**
- * @brief Restarts the watchdog.
+ * @brief Saves all values kept in RAM and resets the MCU by internal watchdog. Does not return.
  * 
- * @test (ID PIN_INTERF_H_T7) (SEV 1) Make sure this function resets the watchdog.
+ * @test (ID PIN_INTERF_H_T7) (SEV 1) Make sure this function resets the MCU within one second.
  * 
+ * @param reason Reset reason stored in post-mortem record, see @ref defines_post_mortem.
  */
-void Pin_Interface_Watchdog_Restart();
+void Pin_Interface_Watchdog_Restart(uint8_t reason);
 
 #endif
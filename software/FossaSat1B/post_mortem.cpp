@@ -0,0 +1,74 @@
+#include "post_mortem.h"
+
+/**
+ * @brief Context of the running program, not cleared on reset.
+ */
+struct postMortemContext_t {
+  uint16_t magic;
+  uint8_t reason;
+  uint8_t phase;
+  uint8_t functionId;
+  int16_t radioError;
+};
+
+postMortemContext_t postMortemContext __attribute__((section(".noinit")));
+
+// MCUSR value on startup, register is cleared before setup
+uint8_t postMortemResetFlags __attribute__((section(".noinit")));
+
+// runs before C runtime initialization: watchdog stays enabled after it reset the MCU, so it has to be disabled right away
+void Post_Mortem_Save_Reset_Flags() __attribute__((naked, used, section(".init3")));
+void Post_Mortem_Save_Reset_Flags() {
+  postMortemResetFlags = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+void Post_Mortem_Init() {
+  postMortemRecord_t record;
+  record.resetFlags = postMortemResetFlags;
+  if(postMortemContext.magic == POST_MORTEM_MAGIC) {
+    record.reason = postMortemContext.reason;
+    record.phase = postMortemContext.phase;
+    record.functionId = postMortemContext.functionId;
+    record.radioError = postMortemContext.radioError;
+  } else {
+    // RAM was not retained (power-on or brown-out)
+    record.reason = POST_MORTEM_REASON_NONE;
+    record.phase = POST_MORTEM_NONE;
+    record.functionId = POST_MORTEM_NONE;
+    record.radioError = ERR_NONE;
+  }
+  record.time = Timekeeping_Get_Time();
+  record.restartCounter = Persistent_Storage_Read<uint16_t>(EEPROM_RESTART_COUNTER_ADDR);
+  Persistent_Storage_Write<postMortemRecord_t>(EEPROM_POST_MORTEM_ADDR, record);
+  FOSSASAT_DEBUG_PRINT(F("PM "));
+  FOSSASAT_DEBUG_PRINT(record.resetFlags, HEX);
+  FOSSASAT_DEBUG_PRINT(' ');
+  FOSSASAT_DEBUG_PRINTLN(record.phase, HEX);
+
+  // start a new context
+  postMortemContext.magic = POST_MORTEM_MAGIC;
+  postMortemContext.reason = POST_MORTEM_REASON_NONE;
+  postMortemContext.phase = POST_MORTEM_PHASE_SETUP;
+  postMortemContext.functionId = POST_MORTEM_NONE;
+  postMortemContext.radioError = ERR_NONE;
+}
+
+void Post_Mortem_Set_Phase(uint8_t phase) {
+  postMortemContext.phase = phase;
+}
+
+void Post_Mortem_Set_Function(uint8_t functionId) {
+  postMortemContext.functionId = functionId;
+}
+
+void Post_Mortem_Set_Radio_Error(int16_t state) {
+  if(state != ERR_NONE) {
+    postMortemContext.radioError = state;
+  }
+}
+
+void Post_Mortem_Set_Reason(uint8_t reason) {
+  postMortemContext.reason = reason;
+}
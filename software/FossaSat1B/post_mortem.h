@@ -0,0 +1,49 @@
+#ifndef POST_MORTEM_H_INCLUDED
+#define POST_MORTEM_H_INCLUDED
+
+#include "FossaSat1B.h"
+
+/**
+ * @file post_mortem.h
+ * @brief This module keeps track of what the program is doing, so that the cause of a reset can be found
+ * after the restart, see @ref defines_post_mortem.
+ */
+
+/**
+ * @brief Saves post-mortem record of the last reset to EEPROM and starts tracking a new context.
+ * Must be called after Timekeeping_Init.
+ *
+ * @test (ID POST_MORTEM_H_T0) (SEV 1) Check that power-on reset is reported without phase and function ID.
+ *
+ */
+void Post_Mortem_Init();
+
+/**
+ * @brief Sets the phase that is currently running.
+ *
+ * @param phase Scheduler task identifier or phase, see @ref defines_post_mortem.
+ */
+void Post_Mortem_Set_Phase(uint8_t phase);
+
+/**
+ * @brief Sets the function ID that is currently being executed.
+ *
+ * @param functionId Function ID, POST_MORTEM_NONE when done.
+ */
+void Post_Mortem_Set_Function(uint8_t functionId);
+
+/**
+ * @brief Records RadioLib error code, success is ignored.
+ *
+ * @param state RadioLib status code.
+ */
+void Post_Mortem_Set_Radio_Error(int16_t state);
+
+/**
+ * @brief Records the reason of the following reset.
+ *
+ * @param reason Reset reason, see @ref defines_post_mortem.
+ */
+void Post_Mortem_Set_Reason(uint8_t reason);
+
+#endif
@@ -5,19 +5,41 @@ powerConfigBits_t powerConfigBits = {
   .lowPowerModeEnabled = LOW_POWER_MODE_ENABLED,
   .mpptTempSwitchEnabled = MPPT_TEMP_SWITCH_ENABLED,
   .mpptKeepAliveEnabled = MPPT_KEEP_ALIVE_ENABLED,
-  .transmitEnabled = TRANSMIT_ENABLED
+  .transmitEnabled = TRANSMIT_ENABLED,
+  .criticalModeActive = CRITICAL_MODE_ACTIVE
 };
 
 powerConfig_t powerConfig = {
   .bits = powerConfigBits
 };
 
+// power mode requested by the latest battery checks, and uptime of the first check that requested it (s)
+uint8_t pendingPowerMode = POWER_MODE_NONE;
+uint32_t pendingPowerModeSince = 0;
+
+// battery charge estimate (mAh), negative when unknown
+float batteryCharge = -1.0;
+
+// last charge estimate saved to EEPROM (%)
+uint8_t batterySavedSoC = SOC_UNKNOWN;
+
+// last shunt current sample used for integration (mA)
+float batteryLastCurrent = 0;
+
+// uptime since which no charging current was seen (s), SOC_REST_UNKNOWN while charging or not sampled yet
+uint32_t batteryRestStart = SOC_REST_UNKNOWN;
+
+// Li-ion open circuit voltage (mV) to state of charge (%) lookup table
+static const uint16_t socVoltages[] PROGMEM = { 3000, 3300, 3500, 3600, 3700, 3800, 3900, 4000, 4100, 4200 };
+static const uint8_t socLevels[] PROGMEM    = {    0,    2,    8,   18,   35,   52,   65,   78,   90,  100 };
+
 void Power_Control_Load_Configuration() {
-  powerConfig.val = Persistent_Storage_Read<uint8_t>(EEPROM_POWER_CONFIG_ADDR);
+  powerConfig.val = logRecord.powerConfig;
 }
 
 void Power_Control_Save_Configuration() {
-  Persistent_Storage_Write<uint8_t>(EEPROM_POWER_CONFIG_ADDR, powerConfig.val);
+  logRecord.powerConfig = powerConfig.val;
+  Persistent_Storage_Save_Log();
 }
 
 void Power_Control_Charge(bool charge) {
@@ -78,7 +100,7 @@ void Power_Control_Delay(uint32_t ms, bool sleep, bool sleepRadio) {
   // calculate number of required loops (rounded up)
   float numLoops = 0.5f;
   if(sleep) {
-    numLoops += (float)ms / 500.0;
+    numLoops += (float)ms * 1000.0 / Timekeeping_Get_Tick_Length();
   } else {
     numLoops += (float)ms / 50.0;
   }
@@ -90,9 +112,19 @@ void Power_Control_Delay(uint32_t ms, bool sleep, bool sleepRadio) {
 
   // perform all loops
   for(uint32_t i = 0; i < (uint32_t)numLoops; i++) {
-    Pin_Interface_Watchdog_Heartbeat();
-    if(sleep) {
+    if(sleep && Pin_Interface_ADC_Burst_Active()) {
+      // power down would stop Timer1 and ADC, idle until the next conversion instead
+      uint32_t start = millis();
+      set_sleep_mode(SLEEP_MODE_IDLE);
+      while(Pin_Interface_ADC_Burst_Active() && (millis() - start < 500)) {
+        sleep_mode();
+      }
+    } else if(sleep) {
       LowPower.powerDown(SLEEP_500MS, ADC_OFF, BOD_OFF);
+      Timekeeping_Add_Tick();
+
+      // Timer2 was stopped, signal the watchdog on wake up
+      Pin_Interface_Watchdog_Service();
     } else {
       delay(50);
     }
@@ -144,6 +176,9 @@ float Power_Control_Get_Battery_Voltage() {
   float val = -999;
   if(Power_Control_INA226_Check()) {
     val = ina.readBusVoltage();
+
+    // MPPT is off, use the reading to correct state of charge estimate
+    Power_Control_Anchor_Charge(val);
   }
 
   // try to switch MPPT on (may be overridden by temperature check)
@@ -169,20 +204,182 @@ float Power_Control_Get_Charging_Current() {
 bool Power_Control_Check_Battery_Limit() {
   // load power configuration from EEPROM
   Power_Control_Load_Configuration();
+  uint8_t mode = Power_Control_Get_Power_Mode();
+
+  // get the mode requested by battery voltage, with separate enter and exit limits
+  float batt = Power_Control_Get_Battery_Voltage();
+  uint8_t target = mode;
+  if(!powerConfig.bits.lowPowerModeEnabled) {
+    target = POWER_MODE_NORMAL;
+  } else if(batt < 0) {
+    // INA226 failed, stay on the safe side without going critical
+    target = POWER_MODE_LOW;
+  } else if(batt <= BATTERY_CRITICAL_VOLTAGE_LIMIT) {
+    target = POWER_MODE_CRITICAL;
+  } else if((mode == POWER_MODE_CRITICAL) && (batt > BATTERY_CRITICAL_VOLTAGE_LIMIT_EXIT)) {
+    target = POWER_MODE_LOW;
+  } else if((mode == POWER_MODE_LOW) && (batt > BATTERY_VOLTAGE_LIMIT_EXIT)) {
+    target = POWER_MODE_NORMAL;
+  } else if((mode == POWER_MODE_NORMAL) && (batt <= BATTERY_VOLTAGE_LIMIT)) {
+    target = POWER_MODE_LOW;
+  }
+
+  // require the same mode to be requested by all checks for some time, independent of how often they run
+  if(target == mode) {
+    pendingPowerMode = POWER_MODE_NONE;
+  } else {
+    uint32_t now = Timekeeping_Get_Uptime();
+    if(target != pendingPowerMode) {
+      pendingPowerMode = target;
+      pendingPowerModeSince = now;
+    }
+
+    // low power mode disabled by command is applied immediately
+    if((now - pendingPowerModeSince >= POWER_MODE_DWELL_TIME) || !powerConfig.bits.lowPowerModeEnabled) {
+      FOSSASAT_DEBUG_PRINT(F("PM"));
+      FOSSASAT_DEBUG_PRINTLN(target);
+      powerConfig.bits.lowPowerModeActive = (target != POWER_MODE_NORMAL);
+      powerConfig.bits.criticalModeActive = (target == POWER_MODE_CRITICAL);
+      pendingPowerMode = POWER_MODE_NONE;
+      mode = target;
+
+      // save power configuration to EEPROM only when it changed
+      Power_Control_Save_Configuration();
+    }
+  }
+
+  return(mode == POWER_MODE_NORMAL);
+}
+
+uint8_t Power_Control_Get_Power_Mode() {
+  if(powerConfig.bits.criticalModeActive) {
+    return(POWER_MODE_CRITICAL);
+  } else if(powerConfig.bits.lowPowerModeActive) {
+    return(POWER_MODE_LOW);
+  }
+  return(POWER_MODE_NORMAL);
+}
+
+void Power_Control_Load_Charge() {
+  batteryCharge = Persistent_Storage_Read<float>(EEPROM_BATTERY_CHARGE_ADDR);
+
+  // erased EEPROM reads as NaN
+  if(!(batteryCharge >= 0)) {
+    batteryCharge = -1.0;
+  }
+  batterySavedSoC = Power_Control_Get_State_Of_Charge();
+}
+
+void Power_Control_Update_Charge(uint32_t elapsed) {
+  #ifdef ENABLE_INA226
+    float current = Power_Control_Get_Charging_Current();
+    if(current <= -999.0) {
+      // INA226 not responding
+      return;
+    }
+    current *= 1000.0;
+
+    // trapezoidal integration of charging current between the two latest samples, minus the load of the power mode
+    if(batteryCharge >= 0) {
+      float net = (batteryLastCurrent + current) / 2.0 - Power_Control_Get_Load_Current();
+      batteryCharge += net * ((float)elapsed / 3600.0);
+      batteryCharge = constrain(batteryCharge, 0, Power_Control_Get_Battery_Capacity());
+    }
+    batteryLastCurrent = current;
 
-  // check battery voltage
-  bool checkPassed = true;
-  if((Power_Control_Get_Battery_Voltage() <= BATTERY_VOLTAGE_LIMIT) && powerConfig.bits.lowPowerModeEnabled) {
-    // activate low power mode
-    powerConfig.bits.lowPowerModeActive = 1;
-    checkPassed = false;
+    // battery is only at rest after a while without charging
+    if(abs(current) > SOC_REST_CURRENT_LIMIT) {
+      batteryRestStart = SOC_REST_UNKNOWN;
+    } else if(batteryRestStart == SOC_REST_UNKNOWN) {
+      batteryRestStart = Timekeeping_Get_Uptime();
+    }
+  #else
+    (void)elapsed;
+  #endif
+
+  // save only significant changes to limit EEPROM wear
+  uint8_t soc = Power_Control_Get_State_Of_Charge();
+  if((soc != SOC_UNKNOWN) && ((batterySavedSoC == SOC_UNKNOWN) || (abs((int16_t)soc - (int16_t)batterySavedSoC) >= SOC_SAVE_THRESHOLD))) {
+    Persistent_Storage_Write<float>(EEPROM_BATTERY_CHARGE_ADDR, batteryCharge);
+    batterySavedSoC = soc;
+  }
+}
+
+void Power_Control_Anchor_Charge(float battVoltage) {
+  // check the battery is at rest, MPPT is off during the reading so the current can't be checked now
+  if((battVoltage <= 0) || (batteryRestStart == SOC_REST_UNKNOWN) || (Timekeeping_Get_Uptime() - batteryRestStart < SOC_REST_INTERVAL)) {
+    return;
+  }
+
+  // interpolate state of charge from open circuit voltage
+  uint16_t mv = battVoltage * 1000.0;
+  const uint8_t last = sizeof(socLevels) - 1;
+  float soc = 0;
+  if(mv >= pgm_read_word(&socVoltages[last])) {
+    soc = pgm_read_byte(&socLevels[last]);
+  } else if(mv > pgm_read_word(&socVoltages[0])) {
+    uint8_t i = 1;
+    while(mv > pgm_read_word(&socVoltages[i])) {
+      i++;
+    }
+    uint16_t v0 = pgm_read_word(&socVoltages[i - 1]);
+    uint16_t v1 = pgm_read_word(&socVoltages[i]);
+    uint8_t s0 = pgm_read_byte(&socLevels[i - 1]);
+    uint8_t s1 = pgm_read_byte(&socLevels[i]);
+    soc = s0 + (float)(s1 - s0) * (float)(mv - v0) / (float)(v1 - v0);
+  }
+  float restCharge = (soc / 100.0) * Power_Control_Get_Battery_Capacity();
+
+  // blend voltage estimate into coulomb counter, or initialize it
+  if(batteryCharge < 0) {
+    batteryCharge = restCharge;
   } else {
-    // deactivate low power mode
-    powerConfig.bits.lowPowerModeActive = 0;
-    checkPassed = true;
+    batteryCharge += SOC_ANCHOR_WEIGHT * (restCharge - batteryCharge);
+  }
+}
+
+uint8_t Power_Control_Get_State_Of_Charge() {
+  if(batteryCharge < 0) {
+    return(SOC_UNKNOWN);
   }
+  return((uint8_t)((batteryCharge / Power_Control_Get_Battery_Capacity()) * 100.0 + 0.5));
+}
+
+float Power_Control_Get_Charge_Margin(uint8_t reserve) {
+  if(batteryCharge < 0) {
+    return(NAN);
+  }
+  return(batteryCharge - ((float)reserve / 100.0) * Power_Control_Get_Battery_Capacity());
+}
 
-  // save power configuration to EEPROM
-  Power_Control_Save_Configuration();
-  return(checkPassed);
+float Power_Control_Get_Load_Current() {
+  switch(Power_Control_Get_Power_Mode()) {
+    case POWER_MODE_CRITICAL:
+      return(SOC_LOAD_CURRENT_CRITICAL);
+    case POWER_MODE_LOW:
+      return(SOC_LOAD_CURRENT_LOW);
+    default:
+      return(SOC_LOAD_CURRENT_NORMAL);
+  }
+}
+
+uint16_t Power_Control_Get_Battery_Capacity() {
+  uint16_t capacity = Persistent_Storage_Read<uint16_t>(EEPROM_BATTERY_CAPACITY_ADDR);
+  if((capacity < BATTERY_CAPACITY_MIN) || (capacity > BATTERY_CAPACITY_MAX)) {
+    return(BATTERY_CAPACITY);
+  }
+  return(capacity);
+}
+
+bool Power_Control_Set_Battery_Capacity(uint16_t capacity) {
+  if((capacity < BATTERY_CAPACITY_MIN) || (capacity > BATTERY_CAPACITY_MAX)) {
+    return(false);
+  }
+
+  // keep state of charge, the estimate in mAh was based on the old capacity
+  if(batteryCharge >= 0) {
+    batteryCharge *= (float)capacity / (float)Power_Control_Get_Battery_Capacity();
+  }
+  Persistent_Storage_Write<uint16_t>(EEPROM_BATTERY_CAPACITY_ADDR, capacity);
+  return(true);
 }
@@ -18,6 +18,7 @@ struct powerConfigBits_t {
   uint8_t mpptTempSwitchEnabled : 1;
   uint8_t mpptKeepAliveEnabled : 1;
   uint8_t transmitEnabled : 1;
+  uint8_t criticalModeActive : 1;
 };
 
 /**
@@ -35,7 +36,7 @@ union powerConfig_t {
 extern powerConfig_t powerConfig;
 
 /**
- * @brief Load the configuration bytes from the EEPROM into RAM.
+ * @brief Load the configuration bytes from the log record mirror (see Persistent_Storage_Load_Log).
  *
  * @test (ID POWER_CONT_H_T0) (SEV 1) Make sure that the power configuration is loaded from EEPROM correctly.
  *
@@ -43,7 +44,7 @@ extern powerConfig_t powerConfig;
 void Power_Control_Load_Configuration();
 
 /**
- * @brief Saves the configuration bytes from RAM into EEPROM.
+ * @brief Saves the configuration bytes from RAM into the wear-leveled log in EEPROM.
  *
  * @test (ID POWER_CONT_H_T1) (SEV 1) Make sure that the power configuration is wrote to the EEPROM correctly.
  *
@@ -76,7 +77,8 @@ void Power_Control_Charge(bool charge);
 uint32_t Power_Control_Get_Sleep_Interval();
 
 /**
- * @brief This function delays the program execution for the given number of milliseconds, while maintaining the watchdog signal to prevent it resetting.
+ * @brief This function delays the program execution for the given number of milliseconds. Liveness token is extended to cover the delay,
+ * watchdog is signalled after each power down period.
  *
  * @test (ID POWER_CONT_H_T8) (SEV 1) Check that the satellite's program is delayed for the given number of seconds without restarting.
  *
@@ -133,10 +135,93 @@ float Power_Control_Get_Charging_Voltage();
 float Power_Control_Get_Charging_Current();
 
 /**
- * @brief Checks whether battery voltage is below low power limit. Will enable low power mode if that is the case.
- * 
- * @return bool Whether battery check passed or not.
+ * @brief Runs the power mode state machine on a new battery voltage reading.
+ * Mode changes need separate enter and exit voltages (see @ref defines_power_management_configuration)
+ * and all checks requesting the new mode for POWER_MODE_DWELL_TIME, no matter how often the check runs. Power configuration is only saved to EEPROM when the mode changes.
+ *
+ * @test (ID POWER_CONT_H_T19) (SEV 1) Check that the power mode does not toggle when battery voltage oscillates around BATTERY_VOLTAGE_LIMIT.
+ *
+ * @return bool Whether battery check passed (satellite is in normal power mode) or not.
  */
 bool Power_Control_Check_Battery_Limit();
 
+/**
+ * @brief Gets the currently active power mode.
+ *
+ * @return uint8_t Current power mode, see @ref defines_power_modes
+ */
+uint8_t Power_Control_Get_Power_Mode();
+
+/**
+ * @brief Loads the battery charge estimate from EEPROM into RAM.
+ *
+ * @test (ID POWER_CONT_H_T15) (SEV 2) Check that the battery charge estimate survives a restart.
+ *
+ */
+void Power_Control_Load_Charge();
+
+/**
+ * @brief Integrates INA226 charging current minus the load of the current power mode into the battery charge estimate
+ * (coulomb counting). The estimate is saved to EEPROM only when state of charge changed by at least SOC_SAVE_THRESHOLD.
+ *
+ * @test (ID POWER_CONT_H_T16) (SEV 2) Check that the charge estimate increases while charging and decreases while discharging.
+ *
+ * @param elapsed Time elapsed since the previous update (s).
+ */
+void Power_Control_Update_Charge(uint32_t elapsed);
+
+/**
+ * @brief Re-anchors the battery charge estimate on a battery voltage reading, if no charging current was seen
+ * for SOC_REST_INTERVAL.
+ *
+ * @test (ID POWER_CONT_H_T17) (SEV 2) Check that unknown charge estimate is initialized from the first rest voltage reading.
+ * @test (ID POWER_CONT_H_T21) (SEV 2) Check that voltage readings taken less than SOC_REST_INTERVAL after charging stopped are ignored.
+ *
+ * @param battVoltage Battery voltage measured with MPPT switched off (V).
+ */
+void Power_Control_Anchor_Charge(float battVoltage);
+
+/**
+ * @brief Gets the estimated battery state of charge.
+ *
+ * @test (ID POWER_CONT_H_T18) (SEV 2) Check that the returned value is between 0 and 100, or SOC_UNKNOWN.
+ *
+ * @return uint8_t State of charge (%), SOC_UNKNOWN if not known yet.
+ */
+uint8_t Power_Control_Get_State_Of_Charge();
+
+/**
+ * @brief Gets the battery charge available above a given state of charge reserve.
+ *
+ * @test (ID POWER_CONT_H_T20) (SEV 2) Check that the margin is negative when state of charge is below reserve.
+ *
+ * @param reserve State of charge that has to remain in the battery (%).
+ * @return float Available charge (mAh), NAN when the charge estimate is not known yet.
+ */
+float Power_Control_Get_Charge_Margin(uint8_t reserve);
+
+/**
+ * @brief Gets the estimated average load current of the current power mode, which INA226 can't measure.
+ *
+ * @return float Load current (mA).
+ */
+float Power_Control_Get_Load_Current();
+
+/**
+ * @brief Gets the battery capacity stored in EEPROM.
+ *
+ * @return uint16_t Battery capacity (mAh), BATTERY_CAPACITY when the stored value is out of range.
+ */
+uint16_t Power_Control_Get_Battery_Capacity();
+
+/**
+ * @brief Sets the battery capacity, the charge estimate is rescaled to keep the state of charge.
+ *
+ * @test (ID POWER_CONT_H_T22) (SEV 2) Check that state of charge is kept when the capacity changes.
+ *
+ * @param capacity New battery capacity (mAh).
+ * @return bool Whether the capacity was within BATTERY_CAPACITY_MIN and BATTERY_CAPACITY_MAX.
+ */
+bool Power_Control_Set_Battery_Capacity(uint16_t capacity);
+
 #endif
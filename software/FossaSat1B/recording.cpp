@@ -0,0 +1,128 @@
+#include "recording.h"
+
+// compressed samples, two nibbles per byte, high nibble first
+uint8_t recordingBuffer[RECORDING_BUFFER_LENGTH];
+uint16_t recordingNibbles = 0;
+
+// number of stored samples and samples still to be taken
+uint16_t recordingCount = 0;
+uint8_t recordingRemaining = 0;
+
+// time between samples (s)
+uint16_t recordingPeriod = 0;
+
+// previous sample of each cell, reference for the next difference
+uint8_t recordingLast[3];
+
+static const uint8_t recordingPins[3] = { ANALOG_IN_SOLAR_A_VOLTAGE_PIN, ANALOG_IN_SOLAR_B_VOLTAGE_PIN, ANALOG_IN_SOLAR_C_VOLTAGE_PIN };
+
+static void Recording_Put_Nibble(uint8_t val) {
+  uint8_t* byte = &recordingBuffer[recordingNibbles / 2];
+  if(recordingNibbles % 2 == 0) {
+    *byte = val << 4;
+  } else {
+    *byte |= val & 0x0F;
+  }
+  recordingNibbles++;
+}
+
+static uint8_t Recording_Get_Nibble(uint16_t pos) {
+  uint8_t byte = recordingBuffer[pos / 2];
+  if(pos % 2 == 0) {
+    return(byte >> 4);
+  }
+  return(byte & 0x0F);
+}
+
+static void Recording_Stop() {
+  recordingRemaining = 0;
+  Scheduler_Set_Task(SCHED_TASK_RECORDING, false, SCHED_TASK_RECORDING, recordingPeriod);
+}
+
+void Recording_Start(uint8_t numSamples, uint16_t period) {
+  if(numSamples == 0) {
+    Recording_Stop();
+    return;
+  }
+
+  recordingNibbles = 0;
+  recordingCount = 0;
+  recordingRemaining = numSamples;
+  recordingPeriod = period;
+  memset(recordingLast, 0, sizeof(recordingLast));
+
+  // first sample is taken right away
+  Scheduler_Set_Task(SCHED_TASK_RECORDING, true, SCHED_TASK_RECORDING, period);
+}
+
+void Recording_Sample() {
+  // stop when battery is low, or when the worst case sample would not fit
+  #ifdef ENABLE_INTERVAL_CONTROL
+  if(powerConfig.bits.lowPowerModeActive) {
+    FOSSASAT_DEBUG_PRINTLN(F("Rec low"));
+    Recording_Stop();
+    return;
+  }
+  #endif
+  if((recordingRemaining == 0) || (recordingNibbles + 3*3 > 2*RECORDING_BUFFER_LENGTH)) {
+    Recording_Stop();
+    return;
+  }
+
+  for(uint8_t i = 0; i < 3; i++) {
+    uint8_t val = Pin_Interface_Read_Voltage(recordingPins[i]) * (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER);
+    int16_t delta = (int16_t)val - recordingLast[i];
+    if((delta >= -RECORDING_MAX_DELTA) && (delta <= RECORDING_MAX_DELTA)) {
+      Recording_Put_Nibble(delta);
+    } else {
+      Recording_Put_Nibble(RECORDING_ESCAPE);
+      Recording_Put_Nibble(val >> 4);
+      Recording_Put_Nibble(val);
+    }
+    recordingLast[i] = val;
+  }
+
+  recordingCount++;
+  recordingRemaining--;
+  if(recordingRemaining == 0) {
+    Recording_Stop();
+  }
+}
+
+uint8_t Recording_Get_Status(uint8_t* buff) {
+  uint8_t* buffPtr = buff;
+  *buffPtr++ = (recordingRemaining > 0);
+  memcpy(buffPtr, &recordingCount, sizeof(uint16_t));
+  buffPtr += sizeof(uint16_t);
+  *buffPtr++ = recordingRemaining;
+  memcpy(buffPtr, &recordingPeriod, sizeof(uint16_t));
+  buffPtr += sizeof(uint16_t);
+  *buffPtr++ = (recordingNibbles + 1) / 2;
+  *buffPtr++ = RECORDING_BUFFER_LENGTH;
+  return(buffPtr - buff);
+}
+
+uint8_t Recording_Read(uint16_t offset, uint8_t* buff) {
+  // differences only make sense from the start, so all samples before the offset have to be decoded
+  uint8_t last[3] = { 0, 0, 0 };
+  uint16_t pos = 0;
+  uint8_t len = 0;
+  for(uint16_t sample = 0; (sample < recordingCount) && (len < 3 * RECORDING_PAGE_SAMPLES); sample++) {
+    for(uint8_t i = 0; i < 3; i++) {
+      uint8_t nibble = Recording_Get_Nibble(pos++);
+      if(nibble == RECORDING_ESCAPE) {
+        last[i] = Recording_Get_Nibble(pos) << 4 | Recording_Get_Nibble(pos + 1);
+        pos += 2;
+      } else {
+        // sign-extend 4-bit difference
+        last[i] += (int8_t)(nibble << 4) >> 4;
+      }
+    }
+
+    if(sample >= offset) {
+      memcpy(buff + len, last, 3);
+      len += 3;
+    }
+  }
+  return(len);
+}
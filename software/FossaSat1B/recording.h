@@ -0,0 +1,49 @@
+#ifndef RECORDING_H_INCLUDED
+#define RECORDING_H_INCLUDED
+
+#include "FossaSat1B.h"
+
+/**
+ * @file recording.h
+ * @brief This module records solar cell voltages in background. Samples are taken by SCHED_TASK_RECORDING
+ * and stored delta-compressed in RAM, see @ref defines_solar_recording.
+ */
+
+/**
+ * @brief Clears the buffer and starts a new recording. Running recording is replaced.
+ *
+ * @test (ID REC_H_T0) (SEV 2) Check that receive windows are not shortened while recording is running.
+ *
+ * @param numSamples Number of samples to take, 0 to stop recording and keep the stored samples.
+ * @param period Time between samples (s).
+ */
+void Recording_Start(uint8_t numSamples, uint16_t period);
+
+/**
+ * @brief Takes one sample of all solar cells. Recording stops when all samples were taken, the buffer is full
+ * or low power mode is active.
+ *
+ */
+void Recording_Sample();
+
+/**
+ * @brief Gets recording status: running flag (uint8_t), stored samples (uint16_t), remaining samples (uint8_t),
+ * period (uint16_t, s), used and total buffer length (uint8_t each).
+ *
+ * @param buff Buffer to write to, at least 8 bytes.
+ * @return uint8_t Number of bytes written.
+ */
+uint8_t Recording_Get_Status(uint8_t* buff);
+
+/**
+ * @brief Decompresses stored samples as A, B, C voltages (see FOSSA-Comms VOLTAGE_UNIT).
+ *
+ * @test (ID REC_H_T1) (SEV 2) Check that pages read with consecutive offsets join into the complete recording.
+ *
+ * @param offset Index of the first sample to read.
+ * @param buff Destination buffer, at least 3 * RECORDING_PAGE_SAMPLES bytes.
+ * @return uint8_t Number of bytes written.
+ */
+uint8_t Recording_Read(uint16_t offset, uint8_t* buff);
+
+#endif
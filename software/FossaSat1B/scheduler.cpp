@@ -0,0 +1,365 @@
+#include "scheduler.h"
+
+// task state
+schedulerTask_t schedulerTasks[SCHED_NUM_TASKS];
+
+// uptime when the current scheduling decision was made (s)
+uint32_t schedulerNow = 0;
+
+// battery-dependent delay added to periodic tasks with energy cost (s)
+uint32_t schedulerBackoff = 0;
+
+// uptime of the previous housekeeping (s)
+uint32_t schedulerLastHousekeeping = 0;
+
+static void Scheduler_Task_Battery() {
+  // update power mode
+  Power_Control_Check_Battery_Limit();
+  FOSSASAT_DEBUG_PRINT('C');
+  FOSSASAT_DEBUG_PRINTLN(powerConfig.val, BIN);
+
+  // try to switch MPPT on (may be overridden by temperature check)
+  Power_Control_Charge(true);
+
+  // the lower the battery, the longer the communication cycle
+  schedulerBackoff = Power_Control_Get_Sleep_Interval() / 1000;
+}
+
+static void Scheduler_Task_Sample() {
+  Statistics_Sample();
+}
+
+static void Scheduler_Task_Beacon() {
+  // check battery voltage
+  FOSSASAT_DEBUG_PRINT('B');
+  #ifdef ENABLE_INA226
+  float battVoltage = Power_Control_Get_Battery_Voltage();
+  #else
+  float battVoltage = 3.99;
+  #endif
+  FOSSASAT_DEBUG_PRINTLN(battVoltage, 2);
+
+  // get and update loop number
+  uint8_t numLoops = logRecord.loopCounter;
+  logRecord.loopCounter = numLoops + 1;
+
+  // CW beacon
+  Communication_Set_Modem(MODEM_FSK);
+  FOSSASAT_DEBUG_DELAY(10);
+  #ifdef ENABLE_TRANSMISSION_CONTROL
+  if(!powerConfig.bits.transmitEnabled) {
+    FOSSASAT_DEBUG_PRINTLN(F("Tx off"));
+  } else if(powerConfig.bits.criticalModeActive) {
+    FOSSASAT_DEBUG_PRINTLN(F("Tx crit"));
+  } else {
+  #endif
+
+  if((battVoltage >= BATTERY_CW_BEEP_VOLTAGE_LIMIT) && (numLoops % MORSE_BEACON_LOOP_FREQ == 0)) {
+    // transmit full Morse beacon
+    Communication_Send_Morse_Beacon(battVoltage);
+  } else {
+    // set delay between beeps according to battery voltage
+    float delayLen = battVoltage - MORSE_BATTERY_MIN;
+    if(battVoltage < MORSE_BATTERY_MIN + MORSE_BATTERY_STEP) {
+      delayLen = MORSE_BATTERY_STEP;
+    }
+
+    // this isn't the loop to transmit full Morse beacon, or the battery is low, transmit CW beeps
+    for(uint8_t i = 0; i < NUM_CW_BEEPS; i++) {
+      Communication_CW_Beep(500);
+      Power_Control_Delay(delayLen * 1000, true);
+    }
+  }
+
+  #ifdef ENABLE_TRANSMISSION_CONTROL
+  }
+  #endif
+
+  // wait for a bit
+  FOSSASAT_DEBUG_DELAY(10);
+  Power_Control_Delay(500, true, true);
+}
+
+static void Scheduler_Task_FSK_Info() {
+  // send FSK system info if not in critical power mode
+  Communication_Set_Modem(MODEM_FSK);
+  #ifdef ENABLE_INTERVAL_CONTROL
+  if(!powerConfig.bits.criticalModeActive) {
+    Communication_Send_System_Info();
+  }
+  #else
+    Communication_Send_System_Info();
+  #endif
+
+  // wait for a bit
+  FOSSASAT_DEBUG_DELAY(10);
+  Power_Control_Delay(500, true, true);
+}
+
+static void Scheduler_Task_LoRa_Info() {
+  // send LoRa system info if not in low power mode
+  Communication_Set_Modem(MODEM_LORA);
+  #ifdef ENABLE_INTERVAL_CONTROL
+  if(!powerConfig.bits.lowPowerModeActive) {
+    Communication_Send_System_Info();
+  }
+  #else
+    Communication_Send_System_Info();
+  #endif
+
+  // wait for a bit
+  FOSSASAT_DEBUG_DELAY(10);
+  Power_Control_Delay(500, true, true);
+}
+
+static void Scheduler_Execute(uint8_t id);
+
+static void Scheduler_Receive(uint8_t modem, uint8_t windowLen) {
+  if(powerConfig.bits.lowPowerModeActive) {
+    // use only half of the interval in low power mode
+    windowLen /= 2;
+  }
+  FOSSASAT_DEBUG_PRINTLN(windowLen);
+
+  Communication_Set_Modem(modem);
+  radio.setDio1Action(Communication_Receive_Interrupt);
+  radio.startReceive();
+
+  uint32_t start = Timekeeping_Get_Uptime();
+  while(Timekeeping_Get_Uptime() - start < windowLen) {
+    Power_Control_Delay(500, true);
+    if(dataReceived) {
+      radio.standby();
+      Communication_Process_Packet();
+      radio.startReceive();
+    }
+
+    // keep recording on its schedule, it doesn't use the radio
+    schedulerNow = Timekeeping_Get_Uptime();
+    if(schedulerTasks[SCHED_TASK_RECORDING].enabled && (schedulerTasks[SCHED_TASK_RECORDING].deadline <= schedulerNow)) {
+      Scheduler_Execute(SCHED_TASK_RECORDING);
+    }
+  }
+
+  radio.clearDio1Action();
+}
+
+static void Scheduler_Task_LoRa_Receive() {
+  FOSSASAT_DEBUG_PRINT(F("LR"));
+  Scheduler_Receive(MODEM_LORA, Persistent_Storage_Read<uint8_t>(EEPROM_LORA_RECEIVE_LEN_ADDR));
+}
+
+static void Scheduler_Task_FSK_Receive() {
+  FOSSASAT_DEBUG_PRINT(F("FR"));
+  Scheduler_Receive(MODEM_FSK, Persistent_Storage_Read<uint8_t>(EEPROM_FSK_RECEIVE_LEN_ADDR));
+}
+
+static void Scheduler_Task_Housekeeping() {
+  uint32_t uptime = Timekeeping_Get_Uptime();
+  uint32_t elapsed = uptime - schedulerLastHousekeeping;
+  schedulerLastHousekeeping = uptime;
+  FOSSASAT_DEBUG_PRINT('t');
+  FOSSASAT_DEBUG_PRINTLN(elapsed);
+
+  // save time, loop and frame counters in a single log record
+  Persistent_Storage_Save_Log();
+
+  // save configuration changed since the last housekeeping
+  Persistent_Storage_Flush();
+  FOSSASAT_DEBUG_PRINT(F("EE"));
+  FOSSASAT_DEBUG_PRINTLN(configFlushCounter);
+
+  // roll over statistics epochs
+  Statistics_Update_Epochs(elapsed);
+
+  // update battery charge estimate
+  Power_Control_Update_Charge(elapsed);
+  FOSSASAT_DEBUG_PRINT(F("SoC"));
+  FOSSASAT_DEBUG_PRINTLN(Power_Control_Get_State_Of_Charge());
+}
+
+static void Scheduler_Task_Deployment() {
+  // check automated deployment attempts
+  uint8_t attempts = Persistent_Storage_Read<uint8_t>(EEPROM_DEPLOYMENT_COUNTER_ADDR);
+  if(attempts <= DEPLOYMENT_ATTEMPTS) {
+    // deployment attemp limit not reached yet, attempt more deployments
+    Deployment_Deploy();
+    Scheduler_Arm(SCHED_TASK_DEPLOYMENT, SCHED_DEPLOYMENT_RETRY);
+  }
+}
+
+static void Scheduler_Task_Calibration() {
+  Timekeeping_Calibrate();
+}
+
+static void Scheduler_Task_Command_Queue() {
+  Command_Queue_Run();
+}
+
+static void Scheduler_Task_Recording() {
+  Recording_Sample();
+}
+
+/**
+ * @brief Default task configuration, indexed by task identifier.
+ */
+struct schedulerTaskDefaults_t {
+  schedulerFunc_t func;
+  uint16_t period;      // s
+  uint16_t energy;      // estimated charge used by one run (mAs), 0 if negligible
+};
+
+static const schedulerTaskDefaults_t schedulerDefaults[SCHED_NUM_TASKS] PROGMEM = {
+  { Scheduler_Task_Battery,       SCHED_BATTERY_PERIOD,       0 },
+  { Scheduler_Task_Sample,        SCHED_SAMPLE_PERIOD,        0 },
+  { Scheduler_Task_Beacon,        SCHED_CYCLE_PERIOD,         1080 },
+  { Scheduler_Task_FSK_Info,      SCHED_CYCLE_PERIOD,         20 },
+  { Scheduler_Task_LoRa_Info,     SCHED_CYCLE_PERIOD,         180 },
+  { Scheduler_Task_LoRa_Receive,  SCHED_CYCLE_PERIOD,         200 },
+  { Scheduler_Task_FSK_Receive,   SCHED_CYCLE_PERIOD,         100 },
+  { Scheduler_Task_Housekeeping,  SCHED_HOUSEKEEPING_PERIOD,  0 },
+  { Scheduler_Task_Deployment,    0,                          0 },
+  { Scheduler_Task_Calibration,   TIME_CALIBRATION_PERIOD,    0 },
+  { Scheduler_Task_Command_Queue, 0,                          0 },
+  { Scheduler_Task_Recording,     0,                          0 }
+};
+
+static void Scheduler_Execute(uint8_t id) {
+  schedulerTask_t* task = &schedulerTasks[id];
+  schedulerTaskDefaults_t def;
+  memcpy_P(&def, &schedulerDefaults[id], sizeof(schedulerTaskDefaults_t));
+
+  // reschedule before running, so that the task can re-arm itself
+  if(task->period == 0) {
+    task->enabled = false;
+  } else {
+    uint32_t interval = task->period;
+    if(def.energy > 0) {
+      interval += schedulerBackoff;
+    }
+    task->deadline += interval;
+
+    // skip runs that were missed
+    if(task->deadline <= schedulerNow) {
+      task->deadline = schedulerNow + interval;
+    }
+  }
+
+  // check the battery can cover the task (comparison fails when charge is not known yet)
+  if((def.energy > 0) && (Power_Control_Get_Charge_Margin(TX_RESERVE_SOC) * 3600.0 < def.energy)) {
+    FOSSASAT_DEBUG_PRINT(F("Tskip"));
+    FOSSASAT_DEBUG_PRINTLN(id);
+    return;
+  }
+
+  FOSSASAT_DEBUG_PRINT('T');
+  FOSSASAT_DEBUG_PRINTLN(id);
+  Post_Mortem_Set_Phase(id);
+  def.func();
+  Post_Mortem_Set_Phase(POST_MORTEM_PHASE_IDLE);
+}
+
+void Scheduler_Init() {
+  Post_Mortem_Set_Phase(POST_MORTEM_PHASE_IDLE);
+  schedulerNow = Timekeeping_Get_Uptime();
+  schedulerBackoff = 0;
+  schedulerLastHousekeeping = schedulerNow;
+
+  // all tasks are due right away, in order of their identifiers
+  for(uint8_t i = 0; i < SCHED_NUM_TASKS; i++) {
+    schedulerTasks[i].deadline = schedulerNow;
+    schedulerTasks[i].period = pgm_read_word(&schedulerDefaults[i].period);
+    schedulerTasks[i].priority = i;
+    schedulerTasks[i].enabled = true;
+  }
+  schedulerTasks[SCHED_TASK_HOUSEKEEPING].deadline += SCHED_HOUSEKEEPING_PERIOD;
+  schedulerTasks[SCHED_TASK_DEPLOYMENT].deadline += AUTODEPLOY_DELAY;
+  schedulerTasks[SCHED_TASK_CALIBRATION].deadline += TIME_CALIBRATION_PERIOD;
+  schedulerTasks[SCHED_TASK_RECORDING].enabled = false;
+}
+
+void Scheduler_Run() {
+  // main loop is alive
+  Pin_Interface_Watchdog_Check_In();
+  schedulerNow = Timekeeping_Get_Uptime();
+
+  // find the due task with the highest priority, and the nearest deadline
+  uint8_t due = SCHED_NUM_TASKS;
+  uint32_t next = UINT32_MAX;
+  for(uint8_t i = 0; i < SCHED_NUM_TASKS; i++) {
+    schedulerTask_t* task = &schedulerTasks[i];
+    if(!task->enabled) {
+      continue;
+    }
+
+    if((task->deadline <= schedulerNow) && ((due == SCHED_NUM_TASKS) || (task->priority < schedulerTasks[due].priority))) {
+      due = i;
+    }
+
+    if(task->deadline < next) {
+      next = task->deadline;
+    }
+  }
+
+  if(due < SCHED_NUM_TASKS) {
+    Scheduler_Execute(due);
+    return;
+  }
+
+  // nothing to do, sleep until the next deadline
+  uint32_t interval = SCHED_HOUSEKEEPING_PERIOD;
+  if(next != UINT32_MAX) {
+    interval = next - schedulerNow;
+  }
+
+  // wake up in time to check in
+  if(interval > WATCHDOG_LIVENESS_DEADLINE / 2) {
+    interval = WATCHDOG_LIVENESS_DEADLINE / 2;
+  }
+  FOSSASAT_DEBUG_PRINT('S');
+  FOSSASAT_DEBUG_PRINTLN(interval);
+  FOSSASAT_DEBUG_DELAY(10);
+
+  // listen for frames during the sleep, for as long as the battery allows
+  uint32_t listenLen = Communication_Get_Listen_Length(interval);
+  if((listenLen > 0) && (Communication_Get_Listen_Modem() != LISTEN_DISABLED)) {
+    FOSSASAT_DEBUG_PRINT(F("Lst"));
+    FOSSASAT_DEBUG_PRINTLN(listenLen);
+    if(Communication_Listen(listenLen)) {
+      // received command may have changed the schedule
+      return;
+    }
+    interval -= listenLen;
+  }
+
+  // planned sleep is not a hang
+  Pin_Interface_Watchdog_Extend(interval * 1000);
+  Power_Control_Delay(interval * 1000, true, true);
+}
+
+bool Scheduler_Set_Task(uint8_t task, bool enabled, uint8_t priority, uint16_t period) {
+  if((task >= SCHED_NUM_TASKS) || (priority >= SCHED_NUM_TASKS)) {
+    return(false);
+  }
+
+  // periodic tasks can't be turned into one-shot tasks, or run too often
+  if((pgm_read_word(&schedulerDefaults[task].period) > 0) && (period < SCHED_MIN_PERIOD)) {
+    return(false);
+  }
+
+  // essential tasks can't be disabled, or postponed for too long
+  if(((uint16_t)SCHED_ESSENTIAL_TASKS & (1 << task)) && (!enabled || (period > SCHED_MAX_ESSENTIAL_PERIOD))) {
+    return(false);
+  }
+
+  schedulerTasks[task].deadline = Timekeeping_Get_Uptime();
+  schedulerTasks[task].period = period;
+  schedulerTasks[task].priority = priority;
+  schedulerTasks[task].enabled = enabled;
+  return(true);
+}
+
+void Scheduler_Arm(uint8_t task, uint32_t delay) {
+  schedulerTasks[task].deadline = Timekeeping_Get_Uptime() + delay;
+  schedulerTasks[task].enabled = true;
+}
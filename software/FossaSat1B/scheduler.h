@@ -0,0 +1,66 @@
+#ifndef SCHEDULER_H_INCLUDED
+#define SCHEDULER_H_INCLUDED
+
+#include "FossaSat1B.h"
+
+/**
+ * @file scheduler.h
+ * @brief This module runs periodic and one-shot tasks by their deadlines and sleeps until the next one is due.
+ * Tasks are cooperative: each one runs to completion and the scheduler picks the next task afterwards, see @ref defines_scheduler.
+ */
+
+/**
+ * @brief Task function.
+ */
+typedef void (*schedulerFunc_t)();
+
+/**
+ * @brief Run-time state of a task, defaults are kept in flash.
+ */
+struct schedulerTask_t {
+  uint32_t deadline;    // scheduler time of the next run (s)
+  uint16_t period;      // time between runs (s), 0 for one-shot tasks
+  uint8_t priority;     // lower value runs first
+  uint8_t enabled;      // task is only run when this is non-zero
+};
+
+/**
+ * @brief Resets all tasks to their defaults, deadlines are relative to the current uptime.
+ *
+ */
+void Scheduler_Init();
+
+/**
+ * @brief Runs the due task with the highest priority, or sleeps until the nearest deadline when no task is due.
+ * Part of the sleep is spent listening for frames, see Communication_Listen.
+ *
+ * @test (ID SCHED_H_T0) (SEV 1) Check that a task with energy cost is skipped when the battery charge margin is too low.
+ *
+ */
+void Scheduler_Run();
+
+/**
+ * @brief Changes task configuration. Enabled task is due immediately. Periodic tasks must keep a period of at least
+ * SCHED_MIN_PERIOD, essential tasks (SCHED_ESSENTIAL_TASKS) can't be disabled and their period can't exceed
+ * SCHED_MAX_ESSENTIAL_PERIOD.
+ *
+ * @test (ID SCHED_H_T1) (SEV 1) Check that a disabled task is not run until it is enabled again.
+ * @test (ID SCHED_H_T2) (SEV 1) Check that disabling battery check, housekeeping or receive windows is rejected.
+ *
+ * @param task Task identifier, see @ref defines_scheduler.
+ * @param enabled Whether the task should run.
+ * @param priority New task priority, lower than SCHED_NUM_TASKS.
+ * @param period New task period (s), 0 to run the task only once.
+ * @return bool Whether the new configuration was valid and applied.
+ */
+bool Scheduler_Set_Task(uint8_t task, bool enabled, uint8_t priority, uint16_t period);
+
+/**
+ * @brief Enables a task to run once after a delay, without changing its period.
+ *
+ * @param task Task identifier, see @ref defines_scheduler.
+ * @param delay Time until the task is due (s).
+ */
+void Scheduler_Arm(uint8_t task, uint32_t delay);
+
+#endif
@@ -0,0 +1,125 @@
+#include "spin_estimation.h"
+
+spinEstimate_t Spin_Estimation_Run(uint8_t numSamples, uint16_t samplePeriod) {
+  if(numSamples > SPIN_MAX_SAMPLES) {
+    numSamples = SPIN_MAX_SAMPLES;
+  }
+
+  // samples are read directly, background capture can't run at the same time
+  Pin_Interface_ADC_Burst_Stop();
+
+  // sampling may take longer than the liveness deadline, but it is a requested operation, not a hang
+  Pin_Interface_Watchdog_Extend((uint32_t)numSamples * samplePeriod);
+
+  // record all cells with 8-bit resolution
+  uint8_t samples[3 * SPIN_MAX_SAMPLES];
+  uint8_t recorded = 0;
+  for(; recorded < numSamples; recorded++) {
+    // check if the battery is good enough to continue
+    #ifdef ENABLE_INTERVAL_CONTROL
+    if(!Power_Control_Check_Battery_Limit()) {
+      break;
+    }
+    #endif
+
+    samples[3*recorded] = analogRead(ANALOG_IN_SOLAR_A_VOLTAGE_PIN) >> 2;
+    samples[3*recorded + 1] = analogRead(ANALOG_IN_SOLAR_B_VOLTAGE_PIN) >> 2;
+    samples[3*recorded + 2] = analogRead(ANALOG_IN_SOLAR_C_VOLTAGE_PIN) >> 2;
+
+    // wait for the next measurement
+    Power_Control_Delay(samplePeriod, true, true);
+  }
+
+  return(Spin_Estimation_Process(samples, recorded, samplePeriod));
+}
+
+spinEstimate_t Spin_Estimation_Process(uint8_t* samples, uint8_t numSamples, uint16_t samplePeriod) {
+  spinEstimate_t est = { 0, 0, 0, 0 };
+  if(numSamples < SPIN_MIN_SAMPLES) {
+    return(est);
+  }
+
+  // find cell with the largest variance (scaled by numSamples^2 to stay in integers)
+  int32_t bestVar = -1;
+  uint16_t mean = 0;
+  for(uint8_t axis = 0; axis < 3; axis++) {
+    uint16_t sum = 0;
+    uint32_t sumSq = 0;
+    for(uint8_t i = 0; i < numSamples; i++) {
+      uint8_t x = samples[3*i + axis];
+      sum += x;
+      sumSq += (uint16_t)x * x;
+    }
+    int32_t var = (int32_t)numSamples * sumSq - (int32_t)sum * sum;
+    if(var > bestVar) {
+      bestVar = var;
+      est.axis = axis;
+      mean = (sum + numSamples/2) / numSamples;
+    }
+  }
+
+  // autocorrelation of the mean-removed signal, R(k) is at most SPIN_MAX_SAMPLES * 255^2
+  int32_t r0 = 0;
+  for(uint8_t i = 0; i < numSamples; i++) {
+    int16_t x = (int16_t)samples[3*i + est.axis] - mean;
+    r0 += (int32_t)x * x;
+  }
+  if(r0 == 0) {
+    return(est);
+  }
+
+  // R(k - 2), R(k - 1) and R(k)
+  int32_t prev = r0;
+  int32_t curr = r0;
+  int32_t next = 0;
+  bool descended = false;
+  uint8_t peak = 0;
+  for(uint8_t k = 1; k <= numSamples/2; k++) {
+    next = 0;
+    for(uint8_t i = 0; i + k < numSamples; i++) {
+      next += (int32_t)((int16_t)samples[3*i + est.axis] - mean) * ((int16_t)samples[3*(i + k) + est.axis] - mean);
+    }
+
+    // first local maximum after autocorrelation dropped below zero
+    if(descended && (curr > prev) && (curr >= next)) {
+      peak = k - 1;
+      break;
+    }
+    if(next < 0) {
+      descended = true;
+    }
+    prev = curr;
+    curr = next;
+  }
+  if(peak == 0) {
+    return(est);
+  }
+
+  // confidence is normalized autocorrelation, compensated for the shorter overlap
+  int32_t norm = ((curr * numSamples / (numSamples - peak)) >> 4) * 255 / ((r0 >> 4) + 1);
+  est.confidence = constrain(norm, 0, 255);
+  if(est.confidence < SPIN_MIN_CONFIDENCE) {
+    est.confidence = 0;
+    return(est);
+  }
+
+  // parabolic interpolation of the peak position (1/256 sample)
+  int32_t den = prev - 2*curr + next;
+  int32_t offset = 0;
+  if(den != 0) {
+    offset = ((prev - next) * 128) / den;
+    offset = constrain(offset, -128, 128);
+  }
+  est.period = (((int32_t)peak * 256 + offset) * samplePeriod + 128) / 256;
+
+  // phase from the brightest sample within the last period
+  uint8_t brightest = numSamples - 1;
+  for(uint8_t i = numSamples - 1; i > numSamples - 1 - peak; i--) {
+    if(samples[3*i + est.axis] > samples[3*brightest + est.axis]) {
+      brightest = i;
+    }
+  }
+  est.phase = ((uint16_t)(numSamples - 1 - brightest) * 256) / peak;
+
+  return(est);
+}
@@ -0,0 +1,48 @@
+#ifndef SPIN_ESTIMATION_H_INCLUDED
+#define SPIN_ESTIMATION_H_INCLUDED
+
+#include "FossaSat1B.h"
+
+/**
+ * @file spin_estimation.h
+ * @brief This module estimates satellite rotation from periodic changes in solar cell voltages.
+ */
+
+/**
+ * @brief Result of spin rate estimation.
+ */
+struct spinEstimate_t {
+  uint32_t period;        // rotation period (ms), 0 if no rotation was detected
+  uint8_t phase;          // time since the last illumination peak, as fraction of period (0 - 255)
+  uint8_t confidence;     // normalized autocorrelation at the detected period (0 - 255)
+  uint8_t axis;           // index of the solar cell with largest variation (0 - A, 1 - B, 2 - C)
+};
+
+/**
+ * @brief Samples all solar cells in a timed burst and estimates rotation period and phase.
+ * Autocorrelation of the solar cell with largest variation is calculated using integer arithmetics only,
+ * period is the first autocorrelation peak refined by parabolic interpolation.
+ *
+ * @test (ID SPIN_EST_H_T0) (SEV 2) Check that the burst is stopped when battery check fails.
+ * @test (ID SPIN_EST_H_T1) (SEV 2) Check that a constant illumination results in zero period and confidence.
+ * @test (ID SPIN_EST_H_T2) (SEV 1) Check that the satellite is not reset by the watchdog during a burst longer than WATCHDOG_LIVENESS_DEADLINE.
+ *
+ * @param numSamples Number of samples per solar cell, at most SPIN_MAX_SAMPLES.
+ * @param samplePeriod Time between samples (ms).
+ * @return spinEstimate_t The estimate.
+ */
+spinEstimate_t Spin_Estimation_Run(uint8_t numSamples, uint16_t samplePeriod);
+
+/**
+ * @brief Estimates rotation from already recorded samples.
+ *
+ * @test (ID SPIN_EST_H_T2) (SEV 2) Check that a sampled sine wave results in its period.
+ *
+ * @param samples Recorded samples, interleaved as A, B, C.
+ * @param numSamples Number of samples per solar cell.
+ * @param samplePeriod Time between samples (ms).
+ * @return spinEstimate_t The estimate.
+ */
+spinEstimate_t Spin_Estimation_Process(uint8_t* samples, uint8_t numSamples, uint16_t samplePeriod);
+
+#endif
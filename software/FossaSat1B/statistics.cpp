@@ -0,0 +1,160 @@
+#include "statistics.h"
+
+// accumulators of the current orbit epoch
+statsAccumulator_t statsOrbit[STATS_NUM_CHANNELS];
+
+// seconds elapsed in the current orbit epoch
+uint32_t statsOrbitElapsed = 0;
+
+static void Statistics_Clear(statsAccumulator_t* stats) {
+  stats->count = 0;
+  stats->mean = 0;
+  stats->m2 = 0;
+  stats->min = INT16_MAX;
+  stats->max = INT16_MIN;
+}
+
+static void Statistics_Merge(statsAccumulator_t* dst, const statsAccumulator_t* src) {
+  if(src->count == 0) {
+    return;
+  }
+
+  if(dst->count == 0) {
+    *dst = *src;
+    return;
+  }
+
+  // parallel variant of Welford's method (Chan et al.)
+  uint32_t count = dst->count + src->count;
+  float delta = src->mean - dst->mean;
+  dst->mean += delta * ((float)src->count / count);
+  dst->m2 += src->m2 + delta * delta * ((float)dst->count * src->count / count);
+  dst->count = count;
+
+  if(src->min < dst->min) {
+    dst->min = src->min;
+  }
+
+  if(src->max > dst->max) {
+    dst->max = src->max;
+  }
+}
+
+static uint16_t Statistics_Get_Addr(uint8_t epoch, uint8_t channel) {
+  uint16_t addr = (epoch == STATS_EPOCH_DAY) ? EEPROM_DAILY_STATS_ADDR : EEPROM_LIFETIME_STATS_ADDR;
+  return(addr + channel * sizeof(statsAccumulator_t));
+}
+
+void Statistics_Load() {
+  // erased EEPROM is not a valid accumulator
+  for(uint8_t epoch = STATS_EPOCH_DAY; epoch <= STATS_EPOCH_LIFETIME; epoch++) {
+    if(Persistent_Storage_Read<uint32_t>(Statistics_Get_Addr(epoch, 0)) == 0xFFFFFFFF) {
+      FOSSASAT_DEBUG_PRINT(F("Stats empty "));
+      FOSSASAT_DEBUG_PRINTLN(epoch);
+      Statistics_Reset(epoch);
+    }
+  }
+
+  Statistics_Reset(STATS_EPOCH_ORBIT);
+}
+
+void Statistics_Flush() {
+  // merge orbit into daily and lifetime accumulators, one channel at a time to save RAM
+  for(uint8_t epoch = STATS_EPOCH_DAY; epoch <= STATS_EPOCH_LIFETIME; epoch++) {
+    for(uint8_t channel = 0; channel < STATS_NUM_CHANNELS; channel++) {
+      uint16_t addr = Statistics_Get_Addr(epoch, channel);
+      statsAccumulator_t stats = Persistent_Storage_Read<statsAccumulator_t>(addr);
+      Statistics_Merge(&stats, &statsOrbit[channel]);
+      Persistent_Storage_Write<statsAccumulator_t>(addr, stats);
+    }
+  }
+
+  // check daily epoch
+  uint32_t dailyElapsed = Persistent_Storage_Read<uint32_t>(EEPROM_DAILY_ELAPSED_ADDR) + statsOrbitElapsed;
+  if(dailyElapsed >= STATS_DAY_PERIOD) {
+    FOSSASAT_DEBUG_PRINTLN(F("Stats day"));
+    Statistics_Reset(STATS_EPOCH_DAY);
+  } else {
+    Persistent_Storage_Write<uint32_t>(EEPROM_DAILY_ELAPSED_ADDR, dailyElapsed);
+  }
+
+  Statistics_Reset(STATS_EPOCH_ORBIT);
+}
+
+void Statistics_Update_Epochs(uint32_t elapsed) {
+  statsOrbitElapsed += elapsed;
+  if(statsOrbitElapsed >= STATS_ORBIT_PERIOD) {
+    FOSSASAT_DEBUG_PRINTLN(F("Stats orbit"));
+    Statistics_Flush();
+  }
+}
+
+void Statistics_Reset(uint8_t epoch) {
+  if(epoch == STATS_EPOCH_ORBIT) {
+    for(uint8_t channel = 0; channel < STATS_NUM_CHANNELS; channel++) {
+      Statistics_Clear(&statsOrbit[channel]);
+    }
+    statsOrbitElapsed = 0;
+    return;
+  }
+
+  statsAccumulator_t stats;
+  Statistics_Clear(&stats);
+  for(uint8_t channel = 0; channel < STATS_NUM_CHANNELS; channel++) {
+    Persistent_Storage_Write<statsAccumulator_t>(Statistics_Get_Addr(epoch, channel), stats);
+  }
+
+  if(epoch == STATS_EPOCH_DAY) {
+    Persistent_Storage_Write<uint32_t>(EEPROM_DAILY_ELAPSED_ADDR, 0);
+  }
+}
+
+void Statistics_Update(uint8_t channel, int16_t val) {
+  if(channel >= STATS_NUM_CHANNELS) {
+    return;
+  }
+  statsAccumulator_t* stats = &statsOrbit[channel];
+
+  // Welford's online update of mean and sum of squared differences
+  stats->count++;
+  float delta = val - stats->mean;
+  stats->mean += delta / stats->count;
+  stats->m2 += delta * (val - stats->mean);
+
+  if(val < stats->min) {
+    stats->min = val;
+  }
+
+  if(val > stats->max) {
+    stats->max = val;
+  }
+}
+
+void Statistics_Sample() {
+  // sample all fields of the telemetry schema that have a statistics channel, scaled the same way as in system info
+  #define TELEMETRY_SAMPLE(name, type, scale, unit, format, stats, source) \
+    if(stats != STATS_NONE) { \
+      Statistics_Update(stats, (type)((source) * (scale))); \
+    }
+  TELEMETRY_SCHEMA(TELEMETRY_SAMPLE)
+  #undef TELEMETRY_SAMPLE
+}
+
+statsSummary_t Statistics_Get(uint8_t epoch, uint8_t channel) {
+  statsAccumulator_t stats = statsOrbit[channel];
+  if(epoch != STATS_EPOCH_ORBIT) {
+    // stored epochs don't include the current orbit yet
+    stats = Persistent_Storage_Read<statsAccumulator_t>(Statistics_Get_Addr(epoch, channel));
+    Statistics_Merge(&stats, &statsOrbit[channel]);
+  }
+
+  statsSummary_t summary = { 0, stats.mean, 0, 0 };
+  if(stats.count > 0) {
+    summary.min = stats.min;
+    summary.max = stats.max;
+  }
+  if(stats.count > 1) {
+    summary.deviation = sqrt(stats.m2 / (stats.count - 1));
+  }
+  return(summary);
+}
@@ -0,0 +1,96 @@
+#ifndef STATISTICS_H_INCLUDED
+#define STATISTICS_H_INCLUDED
+
+#include "FossaSat1B.h"
+
+/**
+ * @file statistics.h
+ * @brief This module accumulates count, mean, variance, minimum and maximum of measured values.
+ * Samples are accumulated in RAM for the current orbit epoch, at its end they are merged
+ * into daily and lifetime accumulators in EEPROM, see @ref defines_statistics.
+ */
+
+/**
+ * @brief Checks accumulators in EEPROM and starts a new orbit epoch.
+ *
+ */
+void Statistics_Load();
+
+/**
+ * @brief Ends the current orbit epoch: merges it into daily and lifetime accumulators in EEPROM and clears it.
+ * Daily accumulators are cleared when STATS_DAY_PERIOD elapsed.
+ *
+ * @test (ID STATS_H_T0) (SEV 2) Check that statistics survive restart.
+ *
+ */
+void Statistics_Flush();
+
+/**
+ * @brief Advances epoch time, calls Statistics_Flush when the orbit epoch is over.
+ *
+ * @param elapsed Number of seconds elapsed since the last call.
+ */
+void Statistics_Update_Epochs(uint32_t elapsed);
+
+/**
+ * @brief Clears accumulators of a single epoch.
+ *
+ * @test (ID STATS_H_T2) (SEV 2) Check that resetting one epoch does not change the others.
+ *
+ * @param epoch Epoch to clear, see @ref defines_statistics.
+ */
+void Statistics_Reset(uint8_t epoch);
+
+/**
+ * @brief Adds a new sample to accumulator of a channel.
+ *
+ * @test (ID STATS_H_T1) (SEV 2) Check that the mean of samples 1, 2, 3, 4 is 2.5 and standard deviation is 1.29.
+ *
+ * @param channel Statistics channel, see @ref defines_statistics.
+ * @param val The new sample.
+ */
+void Statistics_Update(uint8_t channel, int16_t val);
+
+/**
+ * @brief Reads all sensors and adds the values to their channels, in the same units as system info frame.
+ *
+ * @test (ID STATS_H_T3) (SEV 2) Check that the number of samples increases by one on each call, regardless of transmit enable.
+ *
+ */
+void Statistics_Sample();
+
+/**
+ * @brief Summary of a statistics channel, as sent in statistics frames.
+ */
+struct statsSummary_t {
+  /**
+   * @brief Minimum sample, 0 when there are no samples.
+   */
+  int16_t min;
+
+  /**
+   * @brief Mean of samples.
+   */
+  float mean;
+
+  /**
+   * @brief Maximum sample, 0 when there are no samples.
+   */
+  int16_t max;
+
+  /**
+   * @brief Sample standard deviation, 0 when there are less than 2 samples.
+   */
+  float deviation;
+};
+
+/**
+ * @brief Gets summary of a channel, including samples from the current orbit epoch.
+ *
+ * @param epoch Statistics epoch, see @ref defines_statistics.
+ * @param channel Statistics channel, see @ref defines_statistics.
+ * @return statsSummary_t Summary of the channel.
+ */
+statsSummary_t Statistics_Get(uint8_t epoch, uint8_t channel);
+
+#endif
@@ -1,8 +1,12 @@
 #include "system_info.h"
 
-void System_Info_Set_Callsign(char* newCallsign) {
-  // get length of the new callsign (callsign is saved to EEPROM including terminating NULL)
-  uint8_t newCallsignLen = (uint8_t)strlen(newCallsign) + 1;
+// callsign length without terminating NULL, and its first character
+uint8_t callsignLength = 0;
+uint8_t callsignFirst = 0;
+
+void System_Info_Set_Callsign(char* newCallsign, uint8_t len) {
+  // callsign is saved to EEPROM including terminating NULL
+  uint8_t newCallsignLen = len + 1;
 
   // check new callsign length
   if(newCallsignLen > MAX_STRING_LENGTH) {
@@ -13,14 +17,38 @@ void System_Info_Set_Callsign(char* newCallsign) {
   Persistent_Storage_Write<uint8_t>(EEPROM_CALLSIGN_LEN_ADDR, newCallsignLen);
 
   // write new callsign (including terminating NULL)
-  for(uint8_t i = 0; i < newCallsignLen; i++) {
+  for(uint8_t i = 0; i < len; i++) {
     Persistent_Storage_Write<uint8_t>(EEPROM_CALLSIGN_ADDR + i, (uint8_t)newCallsign[i]);
   }
+  Persistent_Storage_Write<uint8_t>(EEPROM_CALLSIGN_ADDR + len, '\0');
+
+  // update matcher
+  System_Info_Load_Callsign();
 }
 
-void System_Info_Get_Callsign(char* buff, uint8_t len) {
-  // get callsign from EEPROM
-  for(uint8_t i = 0; i < len; i++) {
-    buff[i] = (char)Persistent_Storage_Read<uint8_t>(EEPROM_CALLSIGN_ADDR + i);
+void System_Info_Load_Callsign() {
+  // length is saved including terminating NULL
+  callsignLength = Persistent_Storage_Read<uint8_t>(EEPROM_CALLSIGN_LEN_ADDR);
+  if((callsignLength == 0) || (callsignLength > MAX_STRING_LENGTH)) {
+    callsignLength = 0;
+  } else {
+    callsignLength--;
+  }
+  callsignFirst = Persistent_Storage_Read<uint8_t>(EEPROM_CALLSIGN_ADDR);
+}
+
+const char* System_Info_Get_Callsign() {
+  return((const char*)Persistent_Storage_Get_Config(EEPROM_CALLSIGN_ADDR));
+}
+
+uint8_t System_Info_Get_Callsign_Length() {
+  return(callsignLength);
+}
+
+bool System_Info_Match_Callsign(const uint8_t* frame, size_t len) {
+  // empty callsign (invalid EEPROM) matches nothing, most foreign frames fail on length or the first character
+  if((callsignLength == 0) || (len < callsignLength) || (frame[0] != callsignFirst)) {
+    return(false);
   }
+  return(memcmp(frame, Persistent_Storage_Get_Config(EEPROM_CALLSIGN_ADDR), callsignLength) == 0);
 }
@@ -13,19 +13,43 @@
  * 
  * @test (ID SYS_INF_T0) (SEV 1) Make sure this function writes the callsign to EEPROM.
  * 
- * @param newCallsign String containing the new callsign to use.
+ * @param newCallsign Characters of the new callsign, does not have to be NULL-terminated.
+ * @param len Number of characters.
  */
-void System_Info_Set_Callsign(char* newCallsign);
+void System_Info_Set_Callsign(char* newCallsign, uint8_t len);
 /**
- * @brief Gets the callsign which is current set in EEPROM.
- * 
- * @todo Implement a RAM variable to hold this since EEPROM degrades with use, memory restrictions do not allow this to be alloced in RAM.
- * 
+ * @brief Precomputes callsign matcher from the configuration. Must be called after Persistent_Storage_Load_Config,
+ * afterwards it is refreshed by System_Info_Set_Callsign.
+ *
+ */
+void System_Info_Load_Callsign();
+
+/**
+ * @brief Gets the callsign, which is kept in RAM with the rest of the configuration.
+ *
  * @test (ID SYS_INF_T1) (SEV 1) Make sure that the callsign is retrieved correctly from EEPROM.
- * 
- * @param buff The destination for the callsign.
- * @param len The length of the callsign.
+ *
+ * @return const char* NULL-terminated callsign.
+ */
+const char* System_Info_Get_Callsign();
+
+/**
+ * @brief Gets the number of callsign characters, without terminating NULL.
+ *
+ * @return uint8_t Callsign length.
+ */
+uint8_t System_Info_Get_Callsign_Length();
+
+/**
+ * @brief Checks whether a frame starts with the callsign. Frames that are too short, or differ in the first character,
+ * are rejected without comparing the rest. Nothing matches an empty callsign.
+ *
+ * @test (ID SYS_INF_T2) (SEV 1) Check that frames of other stations are rejected and own frames are accepted.
+ *
+ * @param frame Received frame.
+ * @param len Length of the frame.
+ * @return true when the frame starts with the callsign.
  */
-void System_Info_Get_Callsign(char* buff, uint8_t len);
+bool System_Info_Match_Callsign(const uint8_t* frame, size_t len);
 
 #endif
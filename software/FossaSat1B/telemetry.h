@@ -0,0 +1,91 @@
+#ifndef TELEMETRY_H_INCLUDED
+#define TELEMETRY_H_INCLUDED
+
+/**
+ * @file telemetry.h
+ * @brief Telemetry schema shared by the satellite and the ground station, see @ref defines_telemetry.
+ * This file must not depend on anything but FOSSA-Comms units, so that the ground station can include it.
+ */
+
+/**
+ * @defgroup defines_telemetry Telemetry Schema
+ *
+ * @brief Single definition of the system info frame and statistics channels. Each field is given as
+ * X(name, type, scale, unit, format, stats channel, source):
+ * - name: field name, also used for debug output and by the ground station decoder.
+ * - type: type of the field in the frame.
+ * - scale: frame value is the physical value (V, A, deg. C) multiplied by scale.
+ * - unit: unit of the physical value, printed by the ground station.
+ * - format: how the ground station prints the value, see TELEMETRY_FORMAT_*.
+ * - stats channel: statistics channel of the field, STATS_NONE when it has no statistics.
+ * - source: expression that reads the physical value, only expanded by the satellite.
+ *
+ * Fields are packed to the frame in the order given here, all offsets are resolved at compile time. New fields
+ * must be added to the end, the first fields are defined by FOSSA-Comms. Statistics frames contain min, mean,
+ * max and standard deviation of channels selected by flags (bit n = channel n) in channel order.
+ *
+ * @test (ID CONF_TELEM_T0) (SEV 1) Check that the ground station decodes system info and statistics frames to the values measured on board.
+ *
+ * @{
+ */
+#define STATS_CHARGING_VOLTAGE                          0           /*!< Charging voltage (VOLTAGE_UNIT). */
+#define STATS_CHARGING_CURRENT                          1           /*!< Charging current (CURRENT_UNIT). */
+#define STATS_BATTERY_VOLTAGE                           2           /*!< Battery voltage (VOLTAGE_UNIT). */
+#define STATS_CELL_A_VOLTAGE                            3           /*!< Solar cell A voltage (VOLTAGE_UNIT). */
+#define STATS_CELL_B_VOLTAGE                            4           /*!< Solar cell B voltage (VOLTAGE_UNIT). */
+#define STATS_CELL_C_VOLTAGE                            5           /*!< Solar cell C voltage (VOLTAGE_UNIT). */
+#define STATS_BATTERY_TEMP                              6           /*!< Battery temperature (TEMPERATURE_UNIT). */
+#define STATS_BOARD_TEMP                                7           /*!< Board temperature (TEMPERATURE_UNIT). */
+#define STATS_MCU_TEMP                                  8           /*!< MCU temperature (deg. C). */
+#define STATS_NUM_CHANNELS                              9           /*!< Total number of channels. */
+#define STATS_NUM_FLAG_CHANNELS                         8           /*!< Number of channels that can be requested by statistics flags. */
+#define STATS_NONE                                      0xFF        /*!< Field has no statistics. */
+
+#define TELEMETRY_FORMAT_DEC                            0           /*!< Decimal physical value. */
+#define TELEMETRY_FORMAT_BIN                            1           /*!< Raw value in binary, for flags. */
+#define TELEMETRY_FORMAT_DEC_UNKNOWN                    2           /*!< Decimal physical value, raw value with all bits set means unknown. */
+
+#define TELEMETRY_VOLTAGE_SCALE                         (VOLTAGE_UNIT / VOLTAGE_MULTIPLIER)           /*!< Voltage scale. */
+#define TELEMETRY_CURRENT_SCALE                         (CURRENT_UNIT / CURRENT_MULTIPLIER)           /*!< Current scale. */
+#define TELEMETRY_TEMPERATURE_SCALE                     (TEMPERATURE_UNIT / TEMPERATURE_MULTIPLIER)   /*!< Temperature scale. */
+
+#ifdef ENABLE_INA226
+  #define TELEMETRY_INA226(val, placeholder)            (val)       /*!< INA226 reading. */
+#else
+  #define TELEMETRY_INA226(val, placeholder)            (placeholder) /*!< Placeholder used when INA226 is disabled. */
+#endif
+
+#define TELEMETRY_SCHEMA(X) \
+  X(batteryVoltage,         uint8_t,  TELEMETRY_VOLTAGE_SCALE,     "V",     TELEMETRY_FORMAT_DEC,         STATS_BATTERY_VOLTAGE,  TELEMETRY_INA226(Power_Control_Get_Battery_Voltage(), 4.02)) \
+  X(batteryChargingCurrent, int16_t,  TELEMETRY_CURRENT_SCALE,     "A",     TELEMETRY_FORMAT_DEC,         STATS_CHARGING_CURRENT, TELEMETRY_INA226(Power_Control_Get_Charging_Current(), 0.056)) \
+  X(batteryChargingVoltage, uint8_t,  TELEMETRY_VOLTAGE_SCALE,     "V",     TELEMETRY_FORMAT_DEC,         STATS_CHARGING_VOLTAGE, TELEMETRY_INA226(Power_Control_Get_Charging_Voltage(), 3.82)) \
+  X(uptimeCounter,          uint32_t, 1,                           "s",     TELEMETRY_FORMAT_DEC,         STATS_NONE,             Timekeeping_Get_Uptime()) \
+  X(powerConfig,            uint8_t,  1,                           "",      TELEMETRY_FORMAT_BIN,         STATS_NONE,             (Power_Control_Load_Configuration(), powerConfig.val)) \
+  X(resetCounter,           uint16_t, 1,                           "",      TELEMETRY_FORMAT_DEC,         STATS_NONE,             Persistent_Storage_Read<uint16_t>(EEPROM_RESTART_COUNTER_ADDR)) \
+  X(solarCellAVoltage,      uint8_t,  TELEMETRY_VOLTAGE_SCALE,     "V",     TELEMETRY_FORMAT_DEC,         STATS_CELL_A_VOLTAGE,   Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_A_VOLTAGE_PIN)) \
+  X(solarCellBVoltage,      uint8_t,  TELEMETRY_VOLTAGE_SCALE,     "V",     TELEMETRY_FORMAT_DEC,         STATS_CELL_B_VOLTAGE,   Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_B_VOLTAGE_PIN)) \
+  X(solarCellCVoltage,      uint8_t,  TELEMETRY_VOLTAGE_SCALE,     "V",     TELEMETRY_FORMAT_DEC,         STATS_CELL_C_VOLTAGE,   Pin_Interface_Read_Voltage(ANALOG_IN_SOLAR_C_VOLTAGE_PIN)) \
+  X(batteryTemperature,     int16_t,  TELEMETRY_TEMPERATURE_SCALE, "deg C", TELEMETRY_FORMAT_DEC,         STATS_BATTERY_TEMP,     Pin_Interface_Read_Temperature(BATTERY_TEMP_SENSOR_ADDR)) \
+  X(boardTemperature,       int16_t,  TELEMETRY_TEMPERATURE_SCALE, "deg C", TELEMETRY_FORMAT_DEC,         STATS_BOARD_TEMP,       Pin_Interface_Read_Temperature(BOARD_TEMP_SENSOR_ADDR)) \
+  X(mcuTemperature,         int8_t,   1,                           "deg C", TELEMETRY_FORMAT_DEC,         STATS_MCU_TEMP,         (Pin_Interface_Read_Temperature_Internal(), Pin_Interface_Read_Temperature_Internal())) \
+  X(stateOfCharge,          uint8_t,  1,                           "%",     TELEMETRY_FORMAT_DEC_UNKNOWN, STATS_NONE,             Power_Control_Get_State_Of_Charge())
+/**
+ * @}
+ */
+
+// offset of each field in the system info frame, the next enumerator continues after the last byte of the field
+#define TELEMETRY_OFFSET(name, type, scale, unit, format, stats, source) TELEMETRY_OFFSET_##name, TELEMETRY_END_##name = TELEMETRY_OFFSET_##name + sizeof(type) - 1,
+enum telemetryOffset_t {
+  TELEMETRY_SCHEMA(TELEMETRY_OFFSET)
+  TELEMETRY_SYSTEM_INFO_LENGTH
+};
+#undef TELEMETRY_OFFSET
+
+// maximum length of statistics, min, mean, max and standard deviation of all channels that can be requested by flags
+#define TELEMETRY_STATS_SIZE(name, type, scale, unit, format, stats, source) + ((stats < STATS_NUM_FLAG_CHANNELS) ? 4*sizeof(type) : 0)
+#define TELEMETRY_STATS_LENGTH                          (0 TELEMETRY_SCHEMA(TELEMETRY_STATS_SIZE))
+
+// fields decoded by FOSSA-Comms can't move
+static_assert(TELEMETRY_OFFSET_mcuTemperature == 18, "System info layout of FOSSA-Comms changed!");
+
+#endif
@@ -0,0 +1,85 @@
+#include "timekeeping.h"
+
+// seconds since reset and sub-second remainder (us)
+uint32_t timekeepingUptime = 0;
+uint32_t timekeepingMicros = 0;
+
+// total time at reset (s)
+uint32_t timekeepingOffset = 0;
+
+// millis() timestamp of the last update
+uint32_t timekeepingLastMillis = 0;
+
+// calibrated length of one power down period (us)
+uint32_t timekeepingTickLength = TIME_TICK_DEFAULT_LENGTH;
+
+static void Timekeeping_Update(uint32_t us) {
+  // add whole seconds separately, elapsed time in microseconds overflows after ~71 minutes between updates
+  uint32_t now = millis();
+  uint32_t elapsed = now - timekeepingLastMillis;
+  timekeepingLastMillis = now;
+  timekeepingUptime += elapsed / 1000;
+  timekeepingMicros += (elapsed % 1000) * 1000 + us;
+  timekeepingUptime += timekeepingMicros / 1000000;
+  timekeepingMicros %= 1000000;
+}
+
+void Timekeeping_Init(uint32_t savedTime) {
+  timekeepingUptime = 0;
+  timekeepingMicros = 0;
+  timekeepingOffset = savedTime;
+  timekeepingLastMillis = millis();
+  FOSSASAT_DEBUG_PRINT(F("Time "));
+  FOSSASAT_DEBUG_PRINTLN(savedTime);
+}
+
+void Timekeeping_Set_Time(uint32_t time) {
+  Timekeeping_Update(0);
+  timekeepingOffset = time - timekeepingUptime;
+}
+
+uint32_t Timekeeping_Get_Time() {
+  Timekeeping_Update(0);
+  return(timekeepingOffset + timekeepingUptime);
+}
+
+uint32_t Timekeeping_Get_Uptime() {
+  Timekeeping_Update(0);
+  return(timekeepingUptime);
+}
+
+void Timekeeping_Add_Tick() {
+  Timekeeping_Update(timekeepingTickLength);
+}
+
+uint32_t Timekeeping_Get_Tick_Length() {
+  return(timekeepingTickLength);
+}
+
+bool Timekeeping_Calibrate() {
+  // start watchdog timer in interrupt mode with the same period as LowPower.powerDown(SLEEP_500MS)
+  cli();
+  wdt_reset();
+  WDTCSR |= (1 << WDCE) | (1 << WDE);
+  WDTCSR = (1 << WDIE) | (1 << WDP2) | (1 << WDP0);
+  sei();
+
+  // idle until the interrupt, Timer0 keeps running and wakes up the MCU every millisecond
+  uint32_t start = micros();
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  while((WDTCSR & (1 << WDIE)) && (micros() - start < 2 * TIME_TICK_DEFAULT_LENGTH)) {
+    sleep_mode();
+  }
+  uint32_t len = micros() - start;
+  wdt_disable();
+
+  // reject measurements far from the nominal value
+  FOSSASAT_DEBUG_PRINT(F("WDT "));
+  FOSSASAT_DEBUG_PRINTLN(len);
+  if((len < TIME_TICK_MIN_LENGTH) || (len > TIME_TICK_MAX_LENGTH)) {
+    return(false);
+  }
+
+  timekeepingTickLength = len;
+  return(true);
+}
@@ -0,0 +1,67 @@
+#ifndef TIMEKEEPING_H_INCLUDED
+#define TIMEKEEPING_H_INCLUDED
+
+#include "FossaSat1B.h"
+
+/**
+ * @file timekeeping.h
+ * @brief This module keeps the only time of the satellite. While awake, time is measured by millis(). While in power down,
+ * it is counted in watchdog timer ticks, whose length is periodically calibrated against micros(), see @ref defines_timekeeping.
+ */
+
+/**
+ * @brief Starts the clock.
+ *
+ * @param savedTime Total time saved in the log record before the last reset (s).
+ */
+void Timekeeping_Init(uint32_t savedTime);
+
+/**
+ * @brief Overrides total time, uptime since reset is not affected.
+ *
+ * @param time New total time (s).
+ */
+void Timekeeping_Set_Time(uint32_t time);
+
+/**
+ * @brief Gets total time, accumulated over all resets.
+ *
+ * @test (ID TIME_H_T0) (SEV 1) Check that total time continues from the last saved value after restart.
+ *
+ * @return uint32_t Total time (s).
+ */
+uint32_t Timekeeping_Get_Time();
+
+/**
+ * @brief Gets time elapsed since the last reset, used for scheduling.
+ *
+ * @test (ID TIME_H_T1) (SEV 1) Check that uptime drifts by less than 1 % from wall clock time over 24 hours of sleep.
+ *
+ * @return uint32_t Uptime (s).
+ */
+uint32_t Timekeeping_Get_Uptime();
+
+/**
+ * @brief Accounts for one power down period, when millis() is not running.
+ *
+ */
+void Timekeeping_Add_Tick();
+
+/**
+ * @brief Gets calibrated length of one power down period.
+ *
+ * @return uint32_t Tick length (us).
+ */
+uint32_t Timekeeping_Get_Tick_Length();
+
+/**
+ * @brief Measures watchdog timer period while awake. Relies on WDT interrupt handler of the LowPower library
+ * to clear WDIE when the period is over.
+ *
+ * @test (ID TIME_H_T2) (SEV 2) Check that the calibrated tick length follows changes of MCU temperature.
+ *
+ * @return bool Whether the measurement was accepted.
+ */
+bool Timekeeping_Calibrate();
+
+#endif
@@ -0,0 +1,145 @@
+/*
+   FOSSASAT-1B Private Frame Decryption Benchmark
+
+   Measures CPU cycles needed to decrypt a private frame using
+   FOSSA-Comms (FCP_Get_OptData_Length followed by FCP_Get_OptData)
+   and using the single-pass path of the satellite firmware
+   (key schedule expanded once, each block decrypted once in place).
+   Both results are compared, so this also checks that the firmware
+   decoder matches frames built by FCP_Encode.
+
+   Cycles are counted by Timer1 without prescaler, results are printed
+   to serial port for optional data lengths from 0 to MAX_OPT_DATA.
+*/
+
+// include all libraries
+#include <FOSSA-Comms.h>
+#include <aes.h>
+#include "crypto.h"
+
+// number of runs averaged for each measurement
+#define NUM_RUNS              16
+
+// longest optional data that is measured
+#define MAX_OPT_DATA          32
+
+// function ID of the encrypted frame, any private command will do
+#define FUNCTION_ID           (PRIVATE_OFFSET + 1)
+
+// satellite callsign
+char callsign[] = "FOSSASAT-1B";
+
+// transmission password
+const char* password = "password";
+
+// encryption key
+const uint8_t encryptionKey[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+                                 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x00};
+
+// key schedule, expanded once as in the firmware
+struct AES_ctx aesContext;
+
+// number of Timer1 overflows during measurement
+volatile uint16_t overflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+  overflows++;
+}
+
+void startCycles() {
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  overflows = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+  TCCR1B = _BV(CS10);
+}
+
+uint32_t stopCycles() {
+  noInterrupts();
+  TCCR1B = 0;
+  uint16_t count = TCNT1;
+  uint32_t ovf = overflows;
+  if(TIFR1 & _BV(TOV1)) {
+    // overflow that was not serviced yet
+    ovf++;
+  }
+  TIMSK1 = 0;
+  interrupts();
+  return((ovf << 16) | count);
+}
+
+// single-pass decoder of the firmware, returns optional data length or -1
+int16_t decryptSinglePass(uint8_t* frame, uint8_t len, uint8_t** optData) {
+  uint8_t callsignLen = strlen(callsign);
+  return(Crypto_Decrypt_Section(&aesContext, password, frame + callsignLen + 1, len - callsignLen - 1, optData));
+}
+
+void setup() {
+  Serial.begin(9600);
+  Serial.println(F("len\tFCP\tsingle\tratio"));
+
+  // expand key schedule, this is done once at startup by the firmware
+  startCycles();
+  AES_init_ctx(&aesContext, encryptionKey);
+  uint32_t keyCycles = stopCycles();
+
+  for(uint8_t optDataLen = 0; optDataLen <= MAX_OPT_DATA; optDataLen += 8) {
+    uint8_t optData[MAX_OPT_DATA];
+    for(uint8_t i = 0; i < optDataLen; i++) {
+      optData[i] = i;
+    }
+
+    // build frame
+    uint8_t len = FCP_Get_Frame_Length(callsign, optDataLen, password);
+    uint8_t frame[64];
+    uint8_t encoded[64];
+    FCP_Encode(encoded, callsign, FUNCTION_ID, optDataLen, optData, encryptionKey, password);
+
+    uint32_t fcpCycles = 0;
+    uint32_t singleCycles = 0;
+    bool match = true;
+    for(uint8_t run = 0; run < NUM_RUNS; run++) {
+      // FOSSA-Comms, decrypts the frame twice and expands the key each time
+      uint8_t fcpData[MAX_OPT_DATA];
+      memcpy(frame, encoded, len);
+      startCycles();
+      int16_t fcpLen = FCP_Get_OptData_Length(callsign, frame, len, encryptionKey, password);
+      if(fcpLen > 0) {
+        FCP_Get_OptData(callsign, frame, len, fcpData, encryptionKey, password);
+      }
+      fcpCycles += stopCycles();
+
+      // single pass, frame is decrypted in place
+      uint8_t* singleData = NULL;
+      memcpy(frame, encoded, len);
+      startCycles();
+      int16_t singleLen = decryptSinglePass(frame, len, &singleData);
+      singleCycles += stopCycles();
+
+      if((singleLen != fcpLen) || ((fcpLen > 0) && (memcmp(singleData, fcpData, fcpLen) != 0))) {
+        match = false;
+      }
+    }
+
+    Serial.print(optDataLen);
+    Serial.print('\t');
+    Serial.print(fcpCycles / NUM_RUNS);
+    Serial.print('\t');
+    Serial.print(singleCycles / NUM_RUNS);
+    Serial.print('\t');
+    Serial.print((float)fcpCycles / singleCycles);
+    if(!match) {
+      Serial.print(F("\tMISMATCH"));
+    }
+    Serial.println();
+  }
+
+  Serial.print(F("key expansion (once): "));
+  Serial.println(keyCycles);
+}
+
+void loop() {
+
+}
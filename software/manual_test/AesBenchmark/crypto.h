@@ -0,0 +1 @@
+../../FossaSat1B/crypto.h
\ No newline at end of file
@@ -18,6 +18,10 @@
 #include <RadioLib.h>
 #include <FOSSA-Comms.h>
 
+// command table and telemetry schema of the satellite, linked from FossaSat1B/commands.h and FossaSat1B/telemetry.h
+#include "commands.h"
+#include "telemetry.h"
+
 //#define USE_GFSK                    // uncomment to use GFSK
 #define USE_SX126X                    // uncomment to use SX126x
 
@@ -33,13 +37,17 @@
 #define SPREADING_FACTOR      11      // -
 #define CODING_RATE           8       // 4/8
 #define SYNC_WORD             0x12    // used as LoRa "sync word", or twice repeated as FSK sync word (0x1212)
+#define SYNC_WORD_MISSION     0x1B    // LoRa sync word of the mission profile, must match FossaSat1B/configuration.h
+#define SYNC_WORD_MISSION_FSK { 0x1B, 0x46, 0x53, 0x42 }   // FSK sync word of the mission profile
 #define OUTPUT_POWER          20      // dBm
 #define CURRENT_LIMIT         140     // mA
 #define LORA_PREAMBLE_LEN     8       // symbols
+#define LORA_WAKE_PREAMBLE_LEN 256    // symbols, must match LISTEN_LORA_PREAMBLE_LENGTH to reach a sleeping satellite
 #define BIT_RATE              9.6     // kbps
 #define FREQ_DEV              5.0     // kHz SSB
 #define RX_BANDWIDTH          39.0    // kHz SSB
 #define FSK_PREAMBLE_LEN      16      // bits
+#define FSK_WAKE_PREAMBLE_LEN 8192    // bits, must match LISTEN_FSK_PREAMBLE_LENGTH to reach a sleeping satellite
 #define DATA_SHAPING          RADIOLIB_SHAPING_0_5     // BT product
 #define TCXO_VOLTAGE          1.6     // volts
 #define WHITENING_INITIAL     0x1FF   // initial whitening LFSR value
@@ -54,6 +62,8 @@ SX1278 radio = new Module(CS, DIO, NRST, RADIOLIB_NC);
 // flags
 volatile bool interruptEnabled = true;
 volatile bool transmissionReceived = false;
+bool wakePreamble = false;
+bool missionSyncWord = false;
 
 // satellite callsign
 char callsign[] = "FOSSASAT-1B";
@@ -74,30 +84,39 @@ void onInterrupt() {
   transmissionReceived = true;
 }
 
-void sendFrame(uint8_t functionId, uint8_t optDataLen = 0, uint8_t* optData = NULL) {
-  // build frame
-  uint8_t len = FCP_Get_Frame_Length(callsign, optDataLen);
-  uint8_t* frame = new uint8_t[len];
-  FCP_Encode(frame, callsign, functionId, optDataLen, optData);
-
-  // send data
-  int state = radio.transmit(frame, len);
-  delete[] frame;
-
-  // check transmission success
-  if (state == ERR_NONE) {
-    Serial.println(F("sent successfully!"));
-  } else {
-    Serial.print(F("failed, code "));
-    Serial.println(state);
+// look up function ID in the command table of the satellite
+bool getCommand(uint8_t functionId, uint8_t* minLen, uint8_t* maxLen, uint8_t* flags) {
+  switch(functionId) {
+    #define COMMAND_CASE(id, min, max, f, energy, func) case id: *minLen = min; *maxLen = max; *flags = f; return(true);
+    COMMAND_TABLE(COMMAND_CASE)
+    #undef COMMAND_CASE
   }
+  return(false);
 }
 
-void sendFrameEncrypted(uint8_t functionId, uint8_t optDataLen = 0, uint8_t* optData = NULL) {
+void sendFrame(uint8_t functionId, uint8_t optDataLen = 0, uint8_t* optData = NULL) {
+  // private commands are encrypted, unknown function IDs are sent as they are
+  uint8_t minLen = 0;
+  uint8_t maxLen = 0;
+  uint8_t flags = 0;
+  if(!getCommand(functionId, &minLen, &maxLen, &flags)) {
+    Serial.print(F("(unknown function ID) "));
+  } else if((optDataLen < minLen) || (optDataLen > maxLen)) {
+    Serial.print(F("(length out of range) "));
+  }
+
   // build frame
-  uint8_t len = FCP_Get_Frame_Length(callsign, optDataLen, password);
-  uint8_t* frame = new uint8_t[len];
-  FCP_Encode(frame, callsign, functionId, optDataLen, optData, encryptionKey, password);
+  uint8_t len = 0;
+  uint8_t* frame = NULL;
+  if(flags & CMD_FLAG_ENCRYPTED) {
+    len = FCP_Get_Frame_Length(callsign, optDataLen, password);
+    frame = new uint8_t[len];
+    FCP_Encode(frame, callsign, functionId, optDataLen, optData, encryptionKey, password);
+  } else {
+    len = FCP_Get_Frame_Length(callsign, optDataLen);
+    frame = new uint8_t[len];
+    FCP_Encode(frame, callsign, functionId, optDataLen, optData);
+  }
 
   // send data
   int state = radio.transmit(frame, len);
@@ -128,12 +147,98 @@ void printControls() {
   Serial.println(F("e - wipe EEPROM"));
   Serial.println(F("L - set Rx window lengths"));
   Serial.println(F("R - retransmit custom"));
-  Serial.println(F("o - get rotation data"));
+  Serial.println(F("o - start solar cell recording"));
+  Serial.println(F("v - get solar cell recording status"));
+  Serial.println(F("V - get recorded solar cells"));
+  Serial.println(F("O - get estimated spin rate"));
+  Serial.println(F("b - start solar cell burst capture"));
+  Serial.println(F("B - get solar cell burst capture"));
   Serial.println(F("u - send packet with unknown function ID"));
   Serial.println(F("s - get stats"));
+  Serial.println(F("x - get orbit stats"));
+  Serial.println(F("X - reset orbit stats"));
+  Serial.println(F("k - disable sensor sampling task"));
+  Serial.println(F("K - enable sensor sampling task"));
+  Serial.println(F("n - disable listening during sleep"));
+  Serial.println(F("N - listen on LoRa during sleep"));
+  Serial.println(F("P - toggle wake-up preamble"));
+  Serial.println(F("q - queue satellite info in 10 minutes"));
+  Serial.println(F("Q - get command queue"));
+  Serial.println(F("g - get queued response from slot 0"));
+  Serial.println(F("G - clear command queue"));
+  Serial.println(F("c - get cause of the last reset"));
+  Serial.println(F("y - use mission sync word for 24 hours"));
+  Serial.println(F("Y - toggle own mission sync word"));
+  Serial.println(F("a - set battery capacity to 2600 mAh"));
   Serial.println(F("------------------------------------"));
 }
 
+// function to print one telemetry value, converted to the unit and format given by the schema, returns false for unknown value
+template <typename T>
+bool printValue(uint8_t* data, float scale, uint8_t format = TELEMETRY_FORMAT_DEC) {
+  T val;
+  memcpy(&val, data, sizeof(T));
+  if((format == TELEMETRY_FORMAT_DEC_UNKNOWN) && (val == (T)~(T)0)) {
+    Serial.print(F("unknown"));
+    return(false);
+  }
+
+  if(format == TELEMETRY_FORMAT_BIN) {
+    Serial.print(F("0b"));
+    Serial.print((unsigned long)val, BIN);
+  } else if(scale != 1) {
+    Serial.print(val / scale, 4);
+  } else if((T)(-1) < 0) {
+    Serial.print((long)val);
+  } else {
+    Serial.print((unsigned long)val);
+  }
+  return(true);
+}
+
+// function to print system info, each field that fits into the frame is decoded as given by the telemetry schema
+void printSystemInfo(uint8_t* data, uint8_t len) {
+  #define TELEMETRY_PRINT_FIELD(name, type, scale, unit, format, stats, source) \
+    if(len >= TELEMETRY_OFFSET_##name + sizeof(type)) { \
+      Serial.print(F(#name " = ")); \
+      if(printValue<type>(data + TELEMETRY_OFFSET_##name, scale, format)) { \
+        Serial.print(F(" " unit)); \
+      } \
+      Serial.println(); \
+    }
+  TELEMETRY_SCHEMA(TELEMETRY_PRINT_FIELD)
+  #undef TELEMETRY_PRINT_FIELD
+}
+
+// function to print min, mean, max and standard deviation of one statistics channel, returns number of bytes read
+template <typename T>
+uint8_t printStatsRow(uint8_t* data, float scale) {
+  for(uint8_t i = 0; i < 4; i++) {
+    Serial.print('\t');
+    printValue<T>(data + i*sizeof(T), scale);
+  }
+  Serial.println();
+  return(4*sizeof(T));
+}
+
+// function to print statistics of channels selected by flags
+void printStats(uint8_t flags, uint8_t* data, uint8_t pos) {
+  Serial.println(F("channel\t[unit]\tmin\tmean\tmax\tstd"));
+  for(uint8_t channel = 0; channel < STATS_NUM_FLAG_CHANNELS; channel++) {
+    if(!(flags & (1 << channel))) {
+      continue;
+    }
+
+    #define TELEMETRY_PRINT_STATS(name, type, scale, unit, format, stats, source) \
+      if(stats == channel) { \
+        Serial.print(F(#name "\t[" unit "]")); \
+        pos += printStatsRow<type>(data + pos, scale); \
+      }
+    TELEMETRY_SCHEMA(TELEMETRY_PRINT_STATS)
+    #undef TELEMETRY_PRINT_STATS
+  }
+}
+
 void decode(uint8_t* respFrame, uint8_t respLen) {
   // print raw data
   Serial.print(F("Received "));
@@ -188,51 +293,7 @@ void decode(uint8_t* respFrame, uint8_t respLen) {
 
     case RESP_SYSTEM_INFO:
       Serial.println(F("System info:"));
-
-      Serial.print(F("batteryVoltage = "));
-      Serial.print(FCP_Get_Battery_Voltage(respOptData));
-      Serial.println(" V");
-
-      Serial.print(F("batteryChargingCurrent = "));
-      Serial.print(FCP_Get_Battery_Charging_Current(respOptData), 4);
-      Serial.println(" mA");
-
-      Serial.print(F("batteryChargingVoltage = "));
-      Serial.print(FCP_Get_Battery_Charging_Voltage(respOptData));
-      Serial.println(" V");
-
-      Serial.print(F("uptimeCounter = "));
-      Serial.println(FCP_Get_Uptime_Counter(respOptData));
-
-      Serial.print(F("powerConfig = 0b"));
-      Serial.println(FCP_Get_Power_Configuration(respOptData), BIN);
-
-      Serial.print(F("resetCounter = "));
-      Serial.println(FCP_Get_Reset_Counter(respOptData));
-
-      Serial.print(F("solarCellAVoltage = "));
-      Serial.print(FCP_Get_Solar_Cell_Voltage(0, respOptData));
-      Serial.println(" V");
-
-      Serial.print(F("solarCellBVoltage = "));
-      Serial.print(FCP_Get_Solar_Cell_Voltage(1, respOptData));
-      Serial.println(" V");
-
-      Serial.print(F("solarCellCVoltage = "));
-      Serial.print(FCP_Get_Solar_Cell_Voltage(2, respOptData));
-      Serial.println(" V");
-
-      Serial.print(F("batteryTemperature = "));
-      Serial.print(FCP_Get_Battery_Temperature(respOptData));
-      Serial.println(" deg C");
-
-      Serial.print(F("boardTemperature = "));
-      Serial.print(FCP_Get_Board_Temperature(respOptData));
-      Serial.println(" deg C");
-
-      Serial.print(F("mcuTemperature = "));
-      Serial.print(FCP_Get_MCU_Temperature(respOptData));
-      Serial.println(" deg C");
+      printSystemInfo(respOptData, respOptDataLen);
       break;
 
     case RESP_PACKET_INFO: {
@@ -262,6 +323,31 @@ void decode(uint8_t* respFrame, uint8_t respLen) {
       Serial.print(F("invalid FSK frames = "));
       memcpy(&counter, respOptData + 8, sizeof(uint16_t));
       Serial.println(counter);
+
+      if(respOptDataLen >= 14) {
+        Serial.print(F("reduced power transmissions = "));
+        memcpy(&counter, respOptData + 10, sizeof(uint16_t));
+        Serial.println(counter);
+
+        Serial.print(F("refused transmissions = "));
+        memcpy(&counter, respOptData + 12, sizeof(uint16_t));
+        Serial.println(counter);
+      }
+
+      if(respOptDataLen >= 28) {
+        // invalid frames since restart, by NACK error class 0x01 - 0x06
+        Serial.print(F("invalid frames (callsign/RX/ID/decryption/length/unknown) ="));
+        for(uint8_t i = 0; i < 6; i++) {
+          memcpy(&counter, respOptData + 14 + i*sizeof(uint16_t), sizeof(uint16_t));
+          Serial.print(' ');
+          Serial.print(counter);
+        }
+        Serial.println();
+
+        Serial.print(F("refused commands = "));
+        memcpy(&counter, respOptData + 26, sizeof(uint16_t));
+        Serial.println(counter);
+      }
     } break;
 
     case RESP_REPEATED_MESSAGE:
@@ -277,116 +363,123 @@ void decode(uint8_t* respFrame, uint8_t respLen) {
       Serial.println(respOptData[0]);
       break;
 
-    case RESP_STATISTICS: {
-      Serial.println(F("Got stats:\t\tunit\tmin\tavg\tmax"));
-      uint8_t flags = respOptData[0];
-      uint8_t pos = 1;
-      if(flags & 0x01) {
-        // charging voltage
-        Serial.print(F("batteryChargingVoltage\t[V]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos + 1));
-        Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Voltage(respOptData, pos + 2));
-        pos += 3;
-      }
-
-      if(flags& 0x02) {
-        // charging current
-        Serial.print(F("batteryChargingCurrent\t[mA]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Current(respOptData, pos));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Current(respOptData, pos + 2));
-        Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Current(respOptData, pos + 4));
-        pos += 6;
-      }
-
-      if(flags & 0x04) {
-        // battery voltage
-        Serial.print(F("batteryVoltage\t\t[V]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos + 1));
-        Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Voltage(respOptData, pos + 2));
-        pos += 3;
-      }
+    case RESP_STATISTICS:
+      Serial.println(F("Got stats:"));
+      printStats(respOptData[0], respOptData, 1);
+      break;
 
-      if(flags & 0x08) {
-        // cell A voltage
-        Serial.print(F("solarCellAVoltage\t[V]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos + 1));
-        Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Voltage(respOptData, pos + 2));
-        pos += 3;
-      }
+    case RESP_EPOCH_STATISTICS:
+      Serial.print(F("Got stats for epoch "));
+      Serial.println(respOptData[0]);
+      printStats(respOptData[1], respOptData, 2);
+      break;
 
-      if(flags & 0x10) {
-        // cell B voltage
-        Serial.print(F("solarCellBVoltage\t[V]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos));
+    case RESP_RECORDED_SOLAR_CELLS:
+      Serial.println(F("Got recorded cells:"));
+      Serial.println(F("A\tB\tC"));
+      for(uint8_t i = 0; i < respOptDataLen; i += 3) {
+        Serial.print(respOptData[i]);
         Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos + 1));
+        Serial.print(respOptData[i+1]);
         Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Voltage(respOptData, pos + 2));
-        pos += 3;
+        Serial.println(respOptData[i+2]);
       }
+      break;
 
-      if(flags & 0x20) {
-        // cell C voltage
-        Serial.print(F("solarCellCVoltage\t[V]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Voltage(respOptData, pos + 1));
-        Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Voltage(respOptData, pos + 2));
-        pos += 3;
-      }
+    case RESP_SPIN_RATE: {
+      Serial.println(F("Got spin rate estimate:"));
+      uint32_t period = 0;
+      memcpy(&period, respOptData, sizeof(uint32_t));
+      Serial.print(F("period = "));
+      Serial.print(period);
+      Serial.println(F(" ms"));
+      Serial.print(F("phase = "));
+      Serial.print(respOptData[4] * 360.0 / 256.0);
+      Serial.println(F(" deg"));
+      Serial.print(F("confidence = "));
+      Serial.println(respOptData[5] / 255.0);
+      Serial.print(F("dominant cell = "));
+      Serial.println((char)('A' + respOptData[6]));
+    } break;
 
-      if(flags & 0x40) {
-        // battery temperature
-        Serial.print(F("batteryTemperature\t[deg C]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Temperature(respOptData, pos));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Temperature(respOptData, pos + 2));
-        Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Temperature(respOptData, pos + 4));
-        pos += 6;
-      }
+    case RESP_SOLAR_RECORDING_STATUS: {
+      Serial.println(F("Got recording status:"));
+      uint16_t count = 0;
+      uint16_t period = 0;
+      memcpy(&count, respOptData + 1, sizeof(uint16_t));
+      memcpy(&period, respOptData + 4, sizeof(uint16_t));
+      Serial.print(F("running = "));
+      Serial.println(respOptData[0]);
+      Serial.print(F("samples = "));
+      Serial.println(count);
+      Serial.print(F("remaining = "));
+      Serial.println(respOptData[3]);
+      Serial.print(F("period = "));
+      Serial.print(period);
+      Serial.println(F(" s"));
+      Serial.print(F("buffer = "));
+      Serial.print(respOptData[6]);
+      Serial.print('/');
+      Serial.print(respOptData[7]);
+      Serial.println(F(" bytes"));
+    } break;
 
-      if(flags & 0x80) {
-        // board temperature
-        Serial.print(F("boardTemperature\t[deg C]"));
-        Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Temperature(respOptData, pos));
+    case RESP_POST_MORTEM: {
+      Serial.println(F("Got post-mortem record:"));
+      int16_t radioError = 0;
+      uint32_t time = 0;
+      uint16_t restarts = 0;
+      memcpy(&radioError, respOptData + 4, sizeof(int16_t));
+      memcpy(&time, respOptData + 6, sizeof(uint32_t));
+      memcpy(&restarts, respOptData + 10, sizeof(uint16_t));
+      Serial.print(F("MCUSR = 0b"));
+      Serial.println(respOptData[0], BIN);
+      Serial.print(F("reason = "));
+      Serial.println(respOptData[1]);
+      Serial.print(F("phase = 0x"));
+      Serial.println(respOptData[2], HEX);
+      Serial.print(F("functionId = 0x"));
+      Serial.println(respOptData[3], HEX);
+      Serial.print(F("radio error = "));
+      Serial.println(radioError);
+      Serial.print(F("time = "));
+      Serial.print(time);
+      Serial.println(F(" s"));
+      Serial.print(F("restart = "));
+      Serial.println(restarts);
+      Serial.println(F("radio recovery (retry, reconfigure, reinit, reboot):"));
+      for(uint8_t i = 12; i + 2 <= respOptDataLen; i += 2) {
+        uint16_t counter = 0;
+        memcpy(&counter, respOptData + i, sizeof(uint16_t));
+        Serial.print(counter);
         Serial.print('\t');
-        Serial.print(FCP_System_Info_Get_Temperature(respOptData, pos + 2));
-        Serial.print('\t');
-        Serial.println(FCP_System_Info_Get_Temperature(respOptData, pos + 4));
-        pos += 6;
       }
+      Serial.println();
     } break;
 
-    case RESP_RECORDED_SOLAR_CELLS:
-      Serial.println(F("Got recorded cells:"));
-      Serial.println(F("A\tB\tC"));
-      for(uint8_t i = 0; i < respOptDataLen; i += 3) {
-        Serial.print(respOptData[i]);
+    case RESP_COMMAND_QUEUE:
+      Serial.println(F("Got command queue:"));
+      Serial.println(F("slot\tstate\tID\ttime [s]"));
+      for(uint8_t i = 0; i + 6 <= respOptDataLen; i += 6) {
+        int32_t offset = 0;
+        memcpy(&offset, respOptData + i + 2, sizeof(int32_t));
+        Serial.print(i / 6);
         Serial.print('\t');
-        Serial.print(respOptData[i+1]);
+        switch(respOptData[i]) {
+          case 0x01:
+            Serial.print(F("pending"));
+            break;
+          case 0x02:
+            Serial.print(F("done"));
+            break;
+          default:
+            Serial.print(F("empty"));
+            break;
+        }
+        Serial.print(F("\t0x"));
+        Serial.print(respOptData[i + 1], HEX);
         Serial.print('\t');
-        Serial.println(respOptData[i+2]);
+        Serial.println(offset);
       }
       break;
 
@@ -394,7 +487,11 @@ void decode(uint8_t* respFrame, uint8_t respLen) {
       Serial.print(F("Frame ACK, functionId = 0x"));
       Serial.print(respOptData[0], HEX);
       Serial.print(F(", result = 0x"));
-      Serial.println(respOptData[1], HEX);
+      Serial.print(respOptData[1], HEX);
+      if(respOptData[1] == CMD_REFUSED) {
+        Serial.print(F(" (refused)"));
+      }
+      Serial.println();
     } break;
 
     default:
@@ -441,14 +538,14 @@ void restart() {
   Serial.print(F("Sending restart request ... "));
 
   // send the frame
-  sendFrameEncrypted(CMD_RESTART);
+  sendFrame(CMD_RESTART);
 }
 
 void wipe() {
   Serial.print(F("Sending wipe request ... "));
 
   // send the frame
-  sendFrameEncrypted(CMD_WIPE_EEPROM);
+  sendFrame(CMD_WIPE_EEPROM);
 }
 
 void setLowPowerMode(uint8_t en) {
@@ -456,7 +553,7 @@ void setLowPowerMode(uint8_t en) {
 
   // send the frame
   uint8_t optData[] = {en};
-  sendFrameEncrypted(CMD_SET_LOW_POWER_ENABLE, 1, optData);
+  sendFrame(CMD_SET_LOW_POWER_ENABLE, 1, optData);
 }
 
 void setMPPTKeepAlive(uint8_t en) {
@@ -464,14 +561,14 @@ void setMPPTKeepAlive(uint8_t en) {
 
   // send the frame
   uint8_t optData[] = {0x01, en};
-  sendFrameEncrypted(CMD_SET_MPPT_MODE, 2, optData);
+  sendFrame(CMD_SET_MPPT_MODE, 2, optData);
 }
 
 void deploy() {
   Serial.print(F("Sending deployment request ... "));
 
   // send the frame
-  sendFrameEncrypted(CMD_DEPLOY);
+  sendFrame(CMD_DEPLOY);
 }
 
 void sendPing() {
@@ -578,7 +675,7 @@ int16_t setLoRa() {
                           BANDWIDTH,
                           SPREADING_FACTOR,
                           CODING_RATE,
-                          SYNC_WORD,
+                          missionSyncWord ? SYNC_WORD_MISSION : SYNC_WORD,
                           OUTPUT_POWER,
                           LORA_PREAMBLE_LEN,
                           TCXO_VOLTAGE);
@@ -598,8 +695,13 @@ int16_t setGFSK() {
                              OUTPUT_POWER,
                              FSK_PREAMBLE_LEN,
                              TCXO_VOLTAGE);
-  uint8_t syncWordFSK[2] = {SYNC_WORD, SYNC_WORD};
-  radio.setSyncWord(syncWordFSK, 2);
+  if(missionSyncWord) {
+    uint8_t syncWordFSK[] = SYNC_WORD_MISSION_FSK;
+    radio.setSyncWord(syncWordFSK, sizeof(syncWordFSK));
+  } else {
+    uint8_t syncWordFSK[2] = {SYNC_WORD, SYNC_WORD};
+    radio.setSyncWord(syncWordFSK, 2);
+  }
   radio.setDataShaping(DATA_SHAPING);
   radio.setCurrentLimit(CURRENT_LIMIT);
   #ifdef USE_SX126X
@@ -616,7 +718,7 @@ void setRxWindows(uint8_t fsk, uint8_t lora) {
 
   // send the frame
   uint8_t optData[] = {fsk, lora};
-  sendFrameEncrypted(CMD_SET_RECEIVE_WINDOWS, 2, optData);
+  sendFrame(CMD_SET_RECEIVE_WINDOWS, 2, optData);
 }
 
 void sendUnknownFrame() {
@@ -630,12 +732,144 @@ void getStats(uint8_t mask) {
   sendFrame(CMD_GET_STATISTICS, 1, &mask);
 }
 
+void getEpochStats(uint8_t epoch, uint8_t mask) {
+  Serial.print(F("Sending epoch stats request ... "));
+  uint8_t optData[2] = { epoch, mask };
+  sendFrame(CMD_GET_EPOCH_STATISTICS, 2, optData);
+}
+
+void resetEpochStats(uint8_t epoch) {
+  Serial.print(F("Sending epoch stats reset ... "));
+  sendFrame(CMD_RESET_EPOCH_STATISTICS, 1, &epoch);
+}
+
+void setTaskSchedule(uint8_t task, uint8_t enabled, uint8_t priority, uint16_t period) {
+  Serial.print(F("Sending task schedule ... "));
+  uint8_t optData[5] = { task, enabled, priority };
+  memcpy(optData + 3, &period, 2);
+  sendFrame(CMD_SET_TASK_SCHEDULE, 5, optData);
+}
+
+void setListenModem(uint8_t modem) {
+  Serial.print(F("Sending listen modem ... "));
+  sendFrame(CMD_SET_LISTEN_MODEM, 1, &modem);
+}
+
+void queueCommand(uint32_t delay, uint8_t functionId, uint8_t optDataLen = 0, uint8_t* optData = NULL) {
+  Serial.print(F("Sending queued command ... "));
+
+  // satellite rejects commands that can't be queued
+  uint8_t minLen = 0;
+  uint8_t maxLen = 0;
+  uint8_t flags = 0;
+  if(!getCommand(functionId, &minLen, &maxLen, &flags) || (flags & CMD_FLAG_NO_QUEUE) || (optDataLen > CMD_QUEUE_DATA_LENGTH)) {
+    Serial.println(F("command can't be queued!"));
+    return;
+  }
+
+  uint8_t queueData[5 + CMD_QUEUE_DATA_LENGTH];
+  memcpy(queueData, &delay, sizeof(uint32_t));
+  queueData[4] = functionId;
+  if(optDataLen > 0) {
+    memcpy(queueData + 5, optData, optDataLen);
+  }
+  sendFrame(CMD_QUEUE_COMMAND, 5 + optDataLen, queueData);
+}
+
+void getCommandQueue() {
+  Serial.print(F("Sending command queue request ... "));
+  sendFrame(CMD_GET_COMMAND_QUEUE);
+}
+
+void getQueuedResponse(uint8_t slot) {
+  Serial.print(F("Sending queued response request ... "));
+  sendFrame(CMD_GET_COMMAND_QUEUE, 1, &slot);
+}
+
+void clearCommandQueue(uint8_t slot) {
+  Serial.print(F("Sending command queue clear ... "));
+  sendFrame(CMD_CLEAR_COMMAND_QUEUE, 1, &slot);
+}
+
+void toggleWakePreamble() {
+  wakePreamble = !wakePreamble;
+  #ifdef USE_GFSK
+  radio.setPreambleLength(wakePreamble ? FSK_WAKE_PREAMBLE_LEN : FSK_PREAMBLE_LEN);
+  #else
+  radio.setPreambleLength(wakePreamble ? LORA_WAKE_PREAMBLE_LEN : LORA_PREAMBLE_LEN);
+  #endif
+  Serial.print(F("Wake-up preamble "));
+  Serial.println(wakePreamble ? F("on") : F("off"));
+}
+
+void setSyncWordProfile(uint8_t profile, uint16_t hours) {
+  Serial.print(F("Sending sync word profile ... "));
+  uint8_t optData[3] = { profile };
+  memcpy(optData + 1, &hours, 2);
+  sendFrame(CMD_SET_SYNC_WORD_PROFILE, 3, optData);
+}
+
+void setBatteryCapacity(uint16_t capacity) {
+  Serial.print(F("Sending battery capacity ... "));
+  uint8_t optData[2];
+  memcpy(optData, &capacity, 2);
+  sendFrame(CMD_SET_BATTERY_CAPACITY, 2, optData);
+}
+
+void toggleSyncWord() {
+  // satellite switches at its next receive window
+  missionSyncWord = !missionSyncWord;
+  #ifdef USE_GFSK
+  setGFSK();
+  #else
+  setLoRa();
+  #endif
+  Serial.print(F("Mission sync word "));
+  Serial.println(missionSyncWord ? F("on") : F("off"));
+}
+
 void recordSolarCells(uint8_t samples, uint16_t period) {
   Serial.print(F("Sending record cells request ... "));
   uint8_t optData[3];
   optData[0] = samples;
   memcpy(optData + 1, &period, 2);
-  sendFrameEncrypted(CMD_RECORD_SOLAR_CELLS, 3, optData);
+  sendFrame(CMD_RECORD_SOLAR_CELLS, 3, optData);
+}
+
+void getSpinRate(uint8_t samples, uint16_t period) {
+  Serial.print(F("Sending spin rate request ... "));
+  uint8_t optData[3];
+  optData[0] = samples;
+  memcpy(optData + 1, &period, 2);
+  sendFrame(CMD_GET_SPIN_RATE, 3, optData);
+}
+
+void startAdcBurst(uint8_t samples, uint16_t rate) {
+  Serial.print(F("Sending burst capture request ... "));
+  uint8_t optData[3];
+  optData[0] = samples;
+  memcpy(optData + 1, &rate, 2);
+  sendFrame(CMD_START_ADC_BURST, 3, optData);
+}
+
+void getSolarRecording() {
+  Serial.print(F("Sending recording status request ... "));
+  sendFrame(CMD_GET_SOLAR_RECORDING);
+}
+
+void getRecordedSolarCells(uint16_t offset) {
+  Serial.print(F("Sending recorded cells request ... "));
+  sendFrame(CMD_GET_SOLAR_RECORDING, 2, (uint8_t*)&offset);
+}
+
+void getPostMortem() {
+  Serial.print(F("Sending post-mortem request ... "));
+  sendFrame(CMD_GET_POST_MORTEM);
+}
+
+void getAdcBurst() {
+  Serial.print(F("Sending burst readout request ... "));
+  sendFrame(CMD_GET_ADC_BURST);
 }
 
 void setup() {
@@ -738,6 +972,21 @@ void loop() {
       case 'o':
         recordSolarCells(40, 1000);
         break;
+      case 'O':
+        getSpinRate(64, 500);
+        break;
+      case 'v':
+        getSolarRecording();
+        break;
+      case 'V':
+        getRecordedSolarCells(0);
+        break;
+      case 'b':
+        startAdcBurst(40, 1000);
+        break;
+      case 'B':
+        getAdcBurst();
+        break;
       case 'u':
         Serial.print(F("Sending unknown frame ... "));
         sendFrame(0xFF);
@@ -745,6 +994,51 @@ void loop() {
       case 's':
         getStats(0xFF);
         break;
+      case 'x':
+        getEpochStats(0, 0xFF);
+        break;
+      case 'X':
+        resetEpochStats(0);
+        break;
+      case 'k':
+        setTaskSchedule(1, 0, 1, 60);
+        break;
+      case 'K':
+        setTaskSchedule(1, 1, 1, 60);
+        break;
+      case 'n':
+        setListenModem(0);
+        break;
+      case 'N':
+        setListenModem('L');
+        break;
+      case 'P':
+        toggleWakePreamble();
+        break;
+      case 'q':
+        queueCommand(600, CMD_TRANSMIT_SYSTEM_INFO);
+        break;
+      case 'Q':
+        getCommandQueue();
+        break;
+      case 'g':
+        getQueuedResponse(0);
+        break;
+      case 'G':
+        clearCommandQueue(0xFF);
+        break;
+      case 'c':
+        getPostMortem();
+        break;
+      case 'y':
+        setSyncWordProfile(1, 24);
+        break;
+      case 'Y':
+        toggleSyncWord();
+        break;
+      case 'a':
+        setBatteryCapacity(2600);
+        break;
       default:
         Serial.print(F("Unknown command: "));
         Serial.println(serialCmd);
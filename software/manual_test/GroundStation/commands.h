@@ -0,0 +1 @@
+../../FossaSat1B/commands.h
\ No newline at end of file
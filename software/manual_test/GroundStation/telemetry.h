@@ -0,0 +1 @@
+../../FossaSat1B/telemetry.h
\ No newline at end of file